@@ -0,0 +1,350 @@
+#include "Batch.h"
+#include "ReadInput.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+bool loadBatchManifest(const string &path, vector<BatchJob> &jobs, string &error){
+
+    jobs.clear();
+    ifstream file(path);
+    if(!file){
+        error = "cannot open " + path;
+        return false;
+    }
+
+    string line;
+    for(int number = 1; getline(file, line); number++){
+        line = line.substr(0, line.find('#'));
+
+        istringstream fields(line);
+        BatchJob job;
+        if(!(fields >> job.trace))
+            continue;
+
+        int width = 0;
+        string engine = "cycle", extra;
+        bool ok = fields >> job.start >> job.count >> width && job.start > 0 && job.count > 0
+            && width > 0 && width <= 65535 / 5;
+        if(ok && fields >> engine)
+            ok = engine == "cycle" || engine == "event";
+        ok = ok && !(fields >> extra);
+
+        if(!ok){
+            ostringstream message;
+            message << path << ":" << number << ": expected \"trace start count width [cycle|event]\"";
+            error = message.str();
+            return false;
+        }
+
+        job.width = width;
+        job.eventEngine = engine == "event";
+        jobs.push_back(job);
+    }
+
+    if(jobs.empty()){
+        error = path + " lists no jobs";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Records of one range of a trace file shared by the jobs whose windows lie in it
+ * Jobs of a file are grouped into ranges of overlapping or adjacent windows, so jobs far apart in the
+ * same file are parsed separately instead of keeping everything between them in memory.
+ * Covers [first, first + records.size()), the union of the jobs' windows or less if the file is shorter
+*/
+struct SharedTrace {
+    string path;
+    long long first, last;      // union of the windows, instruction numbers
+    vector<int> jobs;
+    vector<TraceRecord> records;
+    atomic<int> jobsLeft;       // records are freed when the last job finishes
+};
+
+// Parse a trace (job < 0) or simulate a job
+struct BatchTask {
+    int trace;
+    int job;
+};
+
+/**
+ * Per-thread task deque, the owner works at the back and other threads steal from the front
+*/
+struct WorkerQueue {
+    mutex lock;
+    deque<BatchTask> tasks;
+};
+
+class BatchScheduler {
+  private:
+    const vector<BatchJob> &jobs;
+    vector<PipesimResult> &results;
+    vector<SharedTrace> &traces;
+    vector<WorkerQueue> queues;
+    atomic<long long> pending;  // tasks queued or running
+    atomic<long long> queued;   // tasks in queues
+
+    // Workers without tasks sleep here until one is queued or everything is done
+    mutex idleLock;
+    condition_variable idle;
+    void wakeIdle();
+
+    bool pop(int worker, BatchTask &task);
+    bool steal(int worker, BatchTask &task);
+    void push(int worker, const BatchTask &task);
+
+    void parseTrace(int worker, int trace);
+    void runJob(const BatchTask &task);
+
+  public:
+    // Constructor
+    BatchScheduler(const vector<BatchJob> &jobs, vector<PipesimResult> &results, vector<SharedTrace> &traces,
+        int threads);
+
+    // Runs worker's tasks, and other workers' once it has none, until every task is done
+    void work(int worker);
+};
+
+BatchScheduler::BatchScheduler(const vector<BatchJob> &jobs, vector<PipesimResult> &results,
+    vector<SharedTrace> &traces, int threads) : jobs(jobs), results(results), traces(traces), queues(threads){
+
+    // Parsing is spread round-robin, each parse then queues its trace's jobs with the thread that parsed it
+    pending = queued = traces.size();
+    for(int i = 0; i < (int)traces.size(); i++){
+        BatchTask task = {i, -1};
+        queues[i % threads].tasks.push_back(task);
+    }
+}
+
+bool BatchScheduler::pop(int worker, BatchTask &task){
+    lock_guard<mutex> guard(queues[worker].lock);
+    if(queues[worker].tasks.empty())
+        return false;
+    task = queues[worker].tasks.back();
+    queues[worker].tasks.pop_back();
+    queued--;
+    return true;
+}
+
+bool BatchScheduler::steal(int worker, BatchTask &task){
+    for(int i = 1; i < (int)queues.size(); i++){
+        WorkerQueue &victim = queues[(worker + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if(victim.tasks.empty())
+            continue;
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void BatchScheduler::push(int worker, const BatchTask &task){
+    {
+        lock_guard<mutex> guard(queues[worker].lock);
+        queues[worker].tasks.push_back(task);
+        queued++;
+    }
+    wakeIdle();
+}
+
+/**
+ * Wake the sleeping workers after a task was queued or the last one finished
+ * Taking idleLock first makes sure a worker that just found nothing is already waiting
+*/
+void BatchScheduler::wakeIdle(){
+    { lock_guard<mutex> guard(idleLock); }
+    idle.notify_all();
+}
+
+/**
+ * Decode the union window of a trace and queue the jobs it can serve
+ * Jobs reaching past the end of the file fail here without being queued
+*/
+void BatchScheduler::parseTrace(int worker, int index){
+
+    SharedTrace &trace = traces[index];
+
+    TraceInput input(trace.path, trace.first, trace.last - trace.first + 1);
+    if(!input.file_failed){
+        TraceRecord record;
+        while(trace.first + (long long)trace.records.size() <= trace.last && input.try_next_record(record))
+            trace.records.push_back(record);
+    }
+    input.close_file();
+
+    // Longest job last, so this thread starts on it while others steal the short ones from the front
+    vector<int> runnable;
+    for(int i = 0; i < (int)trace.jobs.size(); i++){
+        const BatchJob &job = jobs[trace.jobs[i]];
+        PipesimResult &result = results[trace.jobs[i]];
+        result.ok = false;
+        result.stats.reset(job.width);
+
+        if(job.start + job.count - 1 >= trace.first + (long long)trace.records.size()){
+            result.error = input.file_failed ? "cannot open " + trace.path :
+                trace.path + " has fewer than " + to_string(job.start + job.count - 1) + " instructions";
+            continue;
+        }
+        runnable.push_back(trace.jobs[i]);
+    }
+
+    sort(runnable.begin(), runnable.end(), [this](int a, int b){
+        return jobs[a].count < jobs[b].count;
+    });
+
+    trace.jobsLeft = runnable.size();
+    if(runnable.empty())
+        vector<TraceRecord>().swap(trace.records);
+
+    pending += runnable.size();
+    for(int i = 0; i < (int)runnable.size(); i++){
+        BatchTask task = {index, runnable[i]};
+        push(worker, task);
+    }
+}
+
+void BatchScheduler::runJob(const BatchTask &task){
+
+    SharedTrace &trace = traces[task.trace];
+    const BatchJob &job = jobs[task.job];
+
+    PipesimOptions options;
+    options.width = job.width;
+    options.eventEngine = job.eventEngine;
+    results[task.job] = pipesimRunRecords(trace.records.data() + (job.start - trace.first), job.count, options);
+
+    if(--trace.jobsLeft == 0)
+        vector<TraceRecord>().swap(trace.records);
+}
+
+void BatchScheduler::work(int worker){
+    BatchTask task;
+    while(pending > 0){
+        if(!pop(worker, task) && !steal(worker, task)){
+            unique_lock<mutex> guard(idleLock);
+            idle.wait(guard, [this](){ return pending == 0 || queued > 0; });
+            continue;
+        }
+
+        if(task.job < 0)
+            parseTrace(worker, task.trace);
+        else
+            runJob(task);
+        if(--pending == 0)
+            wakeIdle();
+    }
+}
+
+/**
+ * Group the jobs into ranges of overlapping or adjacent windows of the same trace file and run them on the pool
+ * @returns one result per job, same order as jobs
+*/
+vector<PipesimResult> runBatch(const vector<BatchJob> &jobs, int threads){
+
+    vector<PipesimResult> results(jobs.size());
+
+    // Jobs by trace file, then by start
+    vector<int> order(jobs.size());
+    for(int i = 0; i < (int)jobs.size(); i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&jobs](int a, int b){
+        if(jobs[a].trace != jobs[b].trace)
+            return jobs[a].trace < jobs[b].trace;
+        return jobs[a].start < jobs[b].start;
+    });
+
+    // A job starts a new range unless its window overlaps or directly follows the current one
+    vector<int> rangeStarts;
+    long long rangeLast = 0;
+    for(int n = 0; n < (int)order.size(); n++){
+        const BatchJob &job = jobs[order[n]];
+        if(n == 0 || job.trace != jobs[order[n - 1]].trace || job.start > rangeLast + 1){
+            rangeStarts.push_back(n);
+            rangeLast = 0;
+        }
+        rangeLast = max(rangeLast, job.start + job.count - 1);
+    }
+
+    vector<SharedTrace> traces(rangeStarts.size());
+    for(int r = 0; r < (int)rangeStarts.size(); r++){
+        SharedTrace &trace = traces[r];
+        int end = r + 1 < (int)rangeStarts.size() ? rangeStarts[r + 1] : order.size();
+        trace.path = jobs[order[rangeStarts[r]]].trace;
+        trace.first = jobs[order[rangeStarts[r]]].start;
+        trace.last = trace.first;
+        for(int n = rangeStarts[r]; n < end; n++){
+            trace.last = max(trace.last, jobs[order[n]].start + jobs[order[n]].count - 1);
+            trace.jobs.push_back(order[n]);
+        }
+    }
+
+    if(threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = min(threads, (int)jobs.size());
+
+    BatchScheduler scheduler(jobs, results, traces, threads);
+
+    vector<thread> pool;
+    for(int t = 1; t < threads; t++)
+        pool.push_back(thread(&BatchScheduler::work, &scheduler, t));
+    scheduler.work(0);
+
+    for(int t = 0; t < (int)pool.size(); t++)
+        pool[t].join();
+
+    return results;
+}
+
+bool writeBatchCsv(const string &path, const vector<BatchJob> &jobs, const vector<PipesimResult> &results){
+
+    FILE *file = path.empty() ? stdout : fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    fprintf(file, "trace,start,count,width,engine,status,cycles,ipc,integer,floating_point,branch,load,store");
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        fprintf(file, ",stall_%s", stallCauseName(i));
+    fprintf(file, "\n");
+
+    for(int i = 0; i < (int)jobs.size(); i++){
+        const BatchJob &job = jobs[i];
+        const PipesimResult &r = results[i];
+
+        fprintf(file, "%s,%lld,%lld,%d,%s,%s", job.trace.c_str(), job.start, job.count, job.width,
+            job.eventEngine ? "event" : "cycle", r.ok ? "ok" : "failed");
+        if(!r.ok){
+            fprintf(file, ",,,,,,,");
+            for(int j = 0; j < STALL_CAUSE_COUNT; j++)
+                fprintf(file, ",");
+            fprintf(file, "\n");
+            continue;
+        }
+
+        fprintf(file, ",%lld,%.6f", r.totals.cycles, r.totals.ipc());
+        for(int j = 0; j < 5; j++)
+            fprintf(file, ",%lld", r.totals.retired[j]);
+        // The event engine doesn't count stalls, its columns stay empty rather than reading as 0
+        for(int j = 0; j < STALL_CAUSE_COUNT; j++){
+            if(r.stallsMeasured)
+                fprintf(file, ",%lld", r.stats.stalls[j]);
+            else
+                fprintf(file, ",");
+        }
+        fprintf(file, "\n");
+    }
+
+    if(file == stdout)
+        return fflush(file) == 0;
+    return fclose(file) == 0;
+}
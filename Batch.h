@@ -0,0 +1,36 @@
+#include <string>
+#include <vector>
+
+#include "pipesim.h"
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+// One simulation of a batch manifest
+struct BatchJob {
+    string trace;
+    long long start;        // 1-based instruction number
+    long long count;
+    unsigned short width;
+    bool eventEngine;
+};
+
+/**
+ * Reads a manifest of "trace start count width [cycle|event]" lines, '#' starts a comment
+ * Trace paths are relative to the working directory and may not contain spaces
+ * @param error description of the first bad line when returning false
+*/
+bool loadBatchManifest(const string &path, vector<BatchJob> &jobs, string &error);
+
+/**
+ * Simulates every job on a work-stealing pool of threads (default: one per core)
+ * Each range of overlapping or adjacent job windows of a trace file is parsed once and freed after its last job;
+ * jobs far apart in the same file get ranges of their own
+ * @returns one result per job, same order as jobs
+*/
+vector<PipesimResult> runBatch(const vector<BatchJob> &jobs, int threads);
+
+// Writes one CSV row per job, to stdout if path is empty; returns false if the file can't be written
+bool writeBatchCsv(const string &path, const vector<BatchJob> &jobs, const vector<PipesimResult> &results);
+
+#endif
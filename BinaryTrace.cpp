@@ -0,0 +1,68 @@
+#include "BinaryTrace.h"
+
+#include <cstring>
+
+bool isBinaryTrace(const char *data, size_t size) {
+    if (size < sizeof(BinaryTraceHeader))
+        return false;
+
+    BinaryTraceHeader header;
+    memcpy(&header, data, sizeof(header));
+    return memcmp(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == BINARY_TRACE_VERSION && header.record_size == sizeof(TraceRecord);
+}
+
+BinaryTraceWriter::BinaryTraceWriter() {
+    file = NULL;
+    record_count = 0;
+}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+    close();
+}
+
+// This function creates the output file and reserves room for the header
+bool BinaryTraceWriter::open(const std::string &path) {
+    close();
+    record_count = 0;
+
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    BinaryTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+// This function appends record with its unused bytes zeroed, so equal traces give equal files
+bool BinaryTraceWriter::write(const TraceRecord &record) {
+    TraceRecord out;
+    memset(&out, 0, sizeof(out));
+    out.program_counter = record.program_counter;
+    out.type = record.type;
+    out.dependency_count = record.dependency_count;
+    for (int i = 0; i < record.dependency_count; i++)
+        out.dependencies[i] = record.dependencies[i];
+
+    record_count++;
+    return fwrite(&out, sizeof(out), 1, file) == 1;
+}
+
+// This function writes the final header and closes the file
+bool BinaryTraceWriter::close() {
+    if (file == NULL)
+        return true;
+
+    BinaryTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.record_count = record_count;
+
+    bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+    return ok;
+}
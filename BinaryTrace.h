@@ -0,0 +1,55 @@
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#include "TraceParser.h"
+
+#ifndef BINARY_TRACE_H_
+#define BINARY_TRACE_H_
+
+/**
+ * Binary trace layout (native little-endian):
+ *  header:  8 byte magic "PSIMTRC", uint32 version, uint32 record size, uint64 record count, uint64 reserved
+ *  records: fixed-width TraceRecord, 64-bit PC, type byte, dependency count, 6 reserved bytes, 4 64-bit dependency PCs
+*/
+#define BINARY_TRACE_MAGIC "PSIMTRC"
+#define BINARY_TRACE_VERSION 1
+
+struct BinaryTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(BinaryTraceHeader) == 32, "binary trace header must stay 32 bytes");
+static_assert(sizeof(TraceRecord) == 48, "binary trace records must stay 48 bytes");
+
+// Checks whether the first bytes of a file are a binary trace header this version can read
+bool isBinaryTrace(const char *data, size_t size);
+
+/**
+ * Writes TraceRecords into a binary trace file
+*/
+class BinaryTraceWriter {
+  private:
+    FILE *file;
+    uint64_t record_count;
+
+  public:
+    // Constructor
+    BinaryTraceWriter();
+    ~BinaryTraceWriter();
+
+    // Creates path and writes a placeholder header, returns false on failure
+    bool open(const std::string &path);
+
+    // Appends one record
+    bool write(const TraceRecord &record);
+
+    // Patches the record count into the header and closes the file
+    bool close();
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include <cstring>
+
+#include "Checkpoint.h"
+
+// Longest trace path accepted when reading, anything larger is a corrupt file
+#define CHECKPOINT_MAX_STRING 65536
+
+CheckpointWriter::CheckpointWriter(){
+    file = NULL;
+    failed = false;
+}
+
+CheckpointWriter::~CheckpointWriter(){
+    if(file != NULL){
+        fclose(file);
+        remove(tmpPath.c_str());
+    }
+}
+
+bool CheckpointWriter::open(const std::string &path){
+    this->path = path;
+    tmpPath = path + ".tmp";
+    failed = false;
+
+    file = fopen(tmpPath.c_str(), "wb");
+    if(file == NULL)
+        return false;
+
+    char magic[8] = CHECKPOINT_MAGIC;
+    failed = fwrite(magic, sizeof(magic), 1, file) != 1;
+    put(CHECKPOINT_VERSION);
+    return !failed;
+}
+
+void CheckpointWriter::put(uint64_t value){
+    if(!failed && fwrite(&value, sizeof(value), 1, file) != 1)
+        failed = true;
+}
+
+void CheckpointWriter::putString(const std::string &value){
+    put(value.size());
+    if(!failed && !value.empty() && fwrite(value.data(), value.size(), 1, file) != 1)
+        failed = true;
+}
+
+bool CheckpointWriter::close(){
+    if(file == NULL)
+        return false;
+
+    bool written = fclose(file) == 0 && !failed;
+    file = NULL;
+
+    if(!written || rename(tmpPath.c_str(), path.c_str()) != 0){
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+CheckpointReader::CheckpointReader(){
+    file = NULL;
+    failed = false;
+}
+
+CheckpointReader::~CheckpointReader(){
+    if(file != NULL)
+        fclose(file);
+}
+
+bool CheckpointReader::open(const std::string &path){
+    file = fopen(path.c_str(), "rb");
+    if(file == NULL)
+        return false;
+
+    char magic[8];
+    failed = fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0;
+    return !failed && get() == CHECKPOINT_VERSION && ok();
+}
+
+uint64_t CheckpointReader::get(){
+    uint64_t value = 0;
+    if(!failed && fread(&value, sizeof(value), 1, file) != 1)
+        failed = true;
+    return value;
+}
+
+std::string CheckpointReader::getString(){
+    uint64_t size = get();
+    if(failed || size > CHECKPOINT_MAX_STRING){
+        failed = true;
+        return "";
+    }
+
+    std::string value(size, '\0');
+    if(size != 0 && fread(&value[0], size, 1, file) != 1)
+        failed = true;
+    return value;
+}
+
+bool CheckpointReader::ok(){
+    return !failed;
+}
+
+bool readCheckpointHeader(const std::string &path, unsigned short &width, CheckpointTrace &trace,
+    uint64_t &instructionsRead){
+
+    CheckpointReader reader;
+    if(!reader.open(path))
+        return false;
+
+    width = (unsigned short)reader.get();
+    trace.path = reader.getString();
+    trace.startInst = (long long)reader.get();
+    trace.instCount = (long long)reader.get();
+    instructionsRead = reader.get();
+
+    return reader.ok() && width > 0 && (long long)instructionsRead <= trace.instCount;
+}
@@ -0,0 +1,82 @@
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+/**
+ * Checkpoint layout (native little-endian, every number a uint64):
+ *  header: 8 byte magic "PSIMCKP", version, pipeline width, trace path (length + bytes), trace start instruction,
+ *          trace instruction count, instructions already read from the trace
+ *  state:  written and read back by Simulator::saveCheckpoint()/restoreCheckpoint() in the same order
+*/
+#define CHECKPOINT_MAGIC "PSIMCKP"
+#define CHECKPOINT_VERSION 2
+
+// Trace window a simulation reads, so a restored run can reopen it where the checkpoint left off
+struct CheckpointTrace {
+    std::string path;
+    long long startInst;
+    long long instCount;
+};
+
+/**
+ * Writes a checkpoint to a temporary file that replaces path only once it is complete,
+ * so a crash while saving leaves the previous checkpoint intact
+*/
+class CheckpointWriter {
+  private:
+    FILE *file;
+    std::string path, tmpPath;
+    bool failed;
+
+  public:
+    // Constructor
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    // Creates the temporary file, returns false on failure
+    bool open(const std::string &path);
+
+    void put(uint64_t value);
+    void putString(const std::string &value);
+
+    // Moves the finished file into place, returns false if anything failed
+    bool close();
+};
+
+/**
+ * Reads back what CheckpointWriter wrote; any short read marks the reader failed
+*/
+class CheckpointReader {
+  private:
+    FILE *file;
+    bool failed;
+
+  public:
+    // Constructor
+    CheckpointReader();
+    ~CheckpointReader();
+
+    // Opens path and checks magic and version, returns false if it is not a readable checkpoint
+    bool open(const std::string &path);
+
+    uint64_t get();
+    std::string getString();
+
+    // False once a read failed
+    bool ok();
+};
+
+/**
+ * Reads the header of a checkpoint
+ * @param width pipeline width the checkpoint was taken at
+ * @param trace trace window of the checkpointed run
+ * @param instructionsRead instructions of the window the run had already read
+ * @returns false if path is not a readable checkpoint
+*/
+bool readCheckpointHeader(const std::string &path, unsigned short &width, CheckpointTrace &trace,
+    uint64_t &instructionsRead);
+
+#endif
@@ -0,0 +1,203 @@
+#include "Dataflow.h"
+#include "ReadInput.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * One instruction of a chunk with its dependencies resolved as far as the chunk allows
+ * A producer >= 0 is the index of an older instruction in the same chunk, -(k + 1) is the chunk's
+ * k-th live-in program counter, whose newest writer came before the chunk (if there was one)
+*/
+struct ChunkInstruction {
+    uint8_t type;
+    uint8_t dependencyCount;
+    int32_t producers[TRACE_MAX_DEPENDENCIES];
+};
+
+struct DataflowChunk {
+    long long first;                            // instruction number of instructions[0]
+    long long requested;
+    vector<ChunkInstruction> instructions;
+    vector<uint64_t> liveIns;                   // program counters read before the chunk writes them
+    unordered_map<uint64_t, int32_t> lastWriter;    // program counter -> index of its newest instruction
+    bool ended;                                 // the trace ended before requested instructions were read
+};
+
+// What the chunks analyzed so far leave behind for the next one
+struct DataflowState {
+    unordered_map<uint64_t, long long> available;   // program counter -> cycle its newest result is usable
+    long long branchResolved;                       // cycle the newest branch left EX
+    long long criticalPath;
+    long long branches;
+    vector<long long> chunkAvailable, liveInAvailable;
+};
+
+/**
+ * Read up to chunk.requested instructions and resolve every dependency inside the chunk
+ * Runs on a worker thread, touches nothing but input and chunk
+*/
+static void resolveChunk(TraceInput &input, DataflowChunk &chunk){
+
+    chunk.instructions.clear();
+    chunk.liveIns.clear();
+    chunk.lastWriter.clear();
+    unordered_map<uint64_t, int32_t> liveInIds;
+
+    TraceRecord record;
+    while((long long)chunk.instructions.size() < chunk.requested && input.try_next_record(record)){
+        ChunkInstruction I;
+        I.type = record.type;
+        I.dependencyCount = record.dependency_count;
+
+        for(int d = 0; d < record.dependency_count; d++){
+            unordered_map<uint64_t, int32_t>::iterator writer = chunk.lastWriter.find(record.dependencies[d]);
+            if(writer != chunk.lastWriter.end()){
+                I.producers[d] = writer->second;
+                continue;
+            }
+
+            unordered_map<uint64_t, int32_t>::iterator liveIn = liveInIds.find(record.dependencies[d]);
+            if(liveIn == liveInIds.end()){
+                liveIn = liveInIds.insert(make_pair(record.dependencies[d], (int32_t)chunk.liveIns.size())).first;
+                chunk.liveIns.push_back(record.dependencies[d]);
+            }
+            I.producers[d] = -(liveIn->second + 1);
+        }
+
+        chunk.lastWriter[record.program_counter] = chunk.instructions.size();
+        chunk.instructions.push_back(I);
+    }
+
+    chunk.ended = (long long)chunk.instructions.size() < chunk.requested;
+}
+
+/**
+ * Schedule a resolved chunk after everything before it, in program order
+ * Live-ins are looked up once per chunk, everything else is array indexing
+*/
+static void stitchChunk(const DataflowChunk &chunk, const FunctionalUnitConfig &units, DataflowState &state){
+
+    state.liveInAvailable.resize(chunk.liveIns.size());
+    for(int k = 0; k < (int)chunk.liveIns.size(); k++){
+        unordered_map<uint64_t, long long>::iterator writer = state.available.find(chunk.liveIns[k]);
+        state.liveInAvailable[k] = writer != state.available.end() ? writer->second : 0;
+    }
+
+    state.chunkAvailable.resize(chunk.instructions.size());
+    for(int i = 0; i < (int)chunk.instructions.size(); i++){
+        const ChunkInstruction &I = chunk.instructions[i];
+        int latency = units.units[I.type].latency;
+
+        // Fetched (IF and DE) once the newest older branch left EX, leaves DE at the earliest in the next cycle
+        long long execute = state.branchResolved + 1;
+        for(int d = 0; d < I.dependencyCount; d++){
+            int32_t producer = I.producers[d];
+            execute = max(execute, producer >= 0 ? state.chunkAvailable[producer] : state.liveInAvailable[-producer - 1]);
+        }
+
+        // ALU and branch results are usable once they leave EX, loads and stores once they leave MM
+        bool memory = I.type == (int)InstructionType::LOAD || I.type == (int)InstructionType::STORE;
+        state.chunkAvailable[i] = execute + (memory ? 1 : 0) + latency;
+
+        if(I.type == (int)InstructionType::BRANCH){
+            state.branchResolved = execute + latency;
+            state.branches++;
+        }
+
+        // Out of its unit's stage after latency cycles, then one cycle each to WB and RT
+        state.criticalPath = max(state.criticalPath, execute + latency + 2);
+    }
+
+    for(unordered_map<uint64_t, int32_t>::const_iterator it = chunk.lastWriter.begin(); it != chunk.lastWriter.end(); it++)
+        state.available[it->first] = state.chunkAvailable[it->second];
+}
+
+/**
+ * Analyze the window in rounds of one chunk per thread: resolve the round's chunks in parallel,
+ * then stitch them in order
+*/
+DataflowLimit analyzeDataflow(const string &traceFile, long long start, long long count,
+    const FunctionalUnitConfig &units, int threads){
+
+    DataflowLimit limit;
+    limit.instructions = limit.branches = limit.criticalPath = 0;
+    limit.ipc = 0;
+
+    // Compressed traces are read front to back by this one reader
+    TraceInput sequential(traceFile, start, count);
+    limit.failed = sequential.file_failed;
+    if(limit.failed)
+        return limit;
+
+    bool compressed = sequential.is_compressed();
+    if(!compressed){
+        sequential.close_file();
+
+        // Index the whole window of a text trace once, so every chunk seeks straight to its first line
+        if(!sequential.is_binary())
+            TraceInput(traceFile, start + count, 1).close_file();
+    }
+
+    long long chunks = (count + DATAFLOW_CHUNK - 1) / DATAFLOW_CHUNK;
+    if(threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = compressed ? 1 : (int)min((long long)threads, chunks);
+
+    DataflowState state;
+    state.branchResolved = 1;
+    state.criticalPath = 0;
+    state.branches = 0;
+
+    vector<DataflowChunk> round(threads);
+    bool ended = false;
+
+    for(long long c = 0; c < chunks && !ended; c += threads){
+        int n = (int)min((long long)threads, chunks - c);
+
+        for(int t = 0; t < n; t++){
+            round[t].first = start + (c + t) * DATAFLOW_CHUNK;
+            round[t].requested = min((long long)DATAFLOW_CHUNK, start + count - round[t].first);
+        }
+
+        if(compressed)
+            resolveChunk(sequential, round[0]);
+        else {
+            vector<thread> pool;
+            for(int t = 0; t < n; t++){
+                pool.push_back(thread([&traceFile, &round, t](){
+                    DataflowChunk &chunk = round[t];
+                    TraceInput input(traceFile, chunk.first, chunk.requested);
+                    if(input.file_failed){
+                        chunk.instructions.clear();
+                        chunk.ended = true;
+                        return;
+                    }
+                    resolveChunk(input, chunk);
+                }));
+            }
+            for(int t = 0; t < (int)pool.size(); t++)
+                pool[t].join();
+        }
+
+        for(int t = 0; t < n && !ended; t++){
+            stitchChunk(round[t], units, state);
+            limit.instructions += round[t].instructions.size();
+            ended = round[t].ended;
+        }
+    }
+
+    limit.branches = state.branches;
+    limit.criticalPath = state.criticalPath;
+    limit.ipc = limit.criticalPath > 0 ? (double)limit.instructions / limit.criticalPath : 0;
+    return limit;
+}
+
+void printDataflowReport(const DataflowLimit &limit){
+
+    cout << "Dataflow Limit (" << limit.instructions << " instructions, " << limit.branches << " branches)\n";
+    printf("Critical path:\t\t\t%lld cycles\n", limit.criticalPath);
+    printf("Dataflow-limited IPC:\t\t%.4f\n", limit.ipc);
+}
@@ -0,0 +1,37 @@
+#include <string>
+
+#include "FunctionalUnits.h"
+
+#ifndef DATAFLOW_H_
+#define DATAFLOW_H_
+
+// Instructions per analysis chunk, a multiple of TRACE_INDEX_STRIDE so chunks start on indexed lines
+#define DATAFLOW_CHUNK (16 * 65536)
+
+/**
+ * Ideal schedule of a trace window: unlimited width and window, no structural hazards
+ * Only the simulator's latency rules remain: a consumer leaves DE once its ALU/branch producers have
+ * left EX and its load/store producers have left MM, and nothing younger is fetched before the newest
+ * older branch has left EX. criticalPath is the cycle the last instruction retires.
+*/
+struct DataflowLimit {
+    long long instructions;     // analyzed, fewer than requested if the trace ends first
+    long long branches;
+    long long criticalPath;     // cycles
+    double ipc;                 // instructions / criticalPath, the dataflow-limited IPC
+    bool failed;                // trace could not be opened or window starts past its end
+};
+
+/**
+ * Computes the dataflow limit of count instructions from start (1-based) in one pass
+ * The window is cut into chunks of DATAFLOW_CHUNK instructions that are parsed and resolved on up to
+ * threads threads at once (default: one per core); dependencies crossing chunk boundaries are stitched
+ * in program order afterwards. Compressed traces can't seek and are read by one thread.
+ * @param units functional unit latencies (counts and pipelining don't limit an ideal machine)
+*/
+DataflowLimit analyzeDataflow(const string &traceFile, long long start, long long count,
+    const FunctionalUnitConfig &units, int threads);
+
+void printDataflowReport(const DataflowLimit &limit);
+
+#endif
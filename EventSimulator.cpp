@@ -0,0 +1,304 @@
+#include "EventSimulator.h"
+
+/**
+ * Parameterized Constructor
+*/
+EventSimulator::EventSimulator(InstructionSource &source, unsigned short width){
+    this->source = &source;
+    this->width = width;
+
+    sequence = 0;
+    retireCycle = vector<long long>(width * 5 + 1, 0);
+    newestProducer = unordered_map<uint64_t, long long>();
+
+    stalls = vector<long long>(1024, -1);
+    stallBase = 0;
+    for(int i = 0; i < 2; i++)
+        intAluBusy[i] = floatAluBusy[i] = beuBusy[i] = loadBusy[i] = storeBusy[i] = 0;
+    branchResolved = 0;
+
+    lastRetireCycle = 0;
+    retiredInCycle = 0;
+
+    simulatedStats[0] = simulatedStats[1] = simulatedStats[2] = simulatedStats[3] = simulatedStats[4] = 0;
+    clock = 1;
+    verbose = 1;
+    setReportInterval(SIMULATOR_REPORT_INTERVAL);
+    setWarmup(0);
+}
+
+void EventSimulator::setVerbose(bool verbose){
+    this->verbose = verbose;
+}
+
+void EventSimulator::setReportInterval(long long cycles){
+    reportInterval = cycles;
+    nextReport = cycles;
+}
+
+void EventSimulator::setWarmup(long long instructions){
+    warmupInstructions = instructions;
+    warmupCycle = -1;
+    warmupRetired = 0;
+    warmedUp = instructions <= 0;
+}
+
+SimulationResults EventSimulator::getResults(){
+
+    SimulationResults results;
+    results.width = width;
+    results.cycles = clock;
+    for(int i = 0; i < 5; i++)
+        results.retired[i] = simulatedStats[i];
+
+    results.measuredCycles = clock - 1 - warmupCycle;
+    results.measuredRetired = results.totalRetired() - warmupRetired;
+    return results;
+}
+
+/**
+ * Helper to decide if an older instruction stalled in cycle
+ * In Simulator a stall ends the walk over currentInstructions, so nothing younger moves in that cycle
+*/
+bool EventSimulator::stalledAt(long long cycle){
+    return stalls[cycle & (stalls.size() - 1)] == cycle;
+}
+
+void EventSimulator::markStall(long long cycle){
+
+    // Grow before a slot still needed from stallBase on could be reused
+    if(cycle - stallBase >= (long long)stalls.size()){
+        vector<long long> grown(stalls.size() * 2, -1);
+        while(cycle - stallBase >= (long long)grown.size())
+            grown.resize(grown.size() * 2, -1);
+
+        for(int i = 0; i < (int)stalls.size(); i++)
+            if(stalls[i] >= stallBase)
+                grown[stalls[i] & (grown.size() - 1)] = stalls[i];
+        stalls.swap(grown);
+    }
+
+    stalls[cycle & (stalls.size() - 1)] = cycle;
+}
+
+/**
+ * Helper to decide if a functional unit is held in cycle
+ * @param unit [cycle acquired, cycle released) of its newest user
+*/
+bool EventSimulator::isBusy(const long long unit[2], long long cycle){
+    return unit[0] <= cycle && cycle < unit[1];
+}
+
+/**
+ * Helper to decide if any producer of I is still in the pipeline window in cycle
+ * Producers were resolved into producers to the newest older instruction with the dependency's program_counter
+*/
+bool EventSimulator::dependenciesInFlight(const Instruction &I, long long cycle){
+
+    long long oldestInFlight = sequence - width * 5;
+
+    for(int i = 0; i < I.dependencyCount; i++){
+        long long producer = (long long)producers[i];
+        if(producers[i] == NO_PRODUCER || producer < oldestInFlight)
+            continue;
+
+        // Removed in the retire step of its retire cycle, after that cycle's decodes
+        if(retireCycle[producer % retireCycle.size()] >= cycle)
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Compute the cycles in which I leaves New, DE and EX
+ * A cycle is skipped without stalling I if an older instruction stalled in it; if I itself can't
+ * move the cycle is marked as a stall for everything younger
+ * @param I instruction to schedule, all older instructions are already scheduled
+ * @param enter first cycle I is in the pipeline window
+*/
+EventSimulator::Timing EventSimulator::schedule(const Instruction &I, long long enter){
+
+    Timing t;
+    long long c = enter;
+
+    // New: fetch waits until the newest older branch has finished EX
+    while(stalledAt(c) || c < branchResolved){
+        if(!stalledAt(c))
+            markStall(c);
+        c++;
+    }
+    t.decode = c++;
+
+    // DE: wait for producers to leave the window and for the functional unit
+    while(true){
+        if(stalledAt(c)){
+            c++;
+            continue;
+        }
+
+        bool stall = dependenciesInFlight(I, c);
+        switch(I.type){
+            case InstructionType::INTEGER:
+                stall = stall || isBusy(intAluBusy, c);
+                break;
+            case InstructionType::FLOATING_POINT:
+                stall = stall || isBusy(floatAluBusy, c);
+                break;
+            case InstructionType::BRANCH:
+                stall = stall || isBusy(beuBusy, c);
+                break;
+            default:
+                break;
+        }
+
+        if(!stall)
+            break;
+        markStall(c++);
+    }
+    t.execute = c++;
+
+    // EX: loads and stores wait for their port
+    while(true){
+        if(stalledAt(c)){
+            c++;
+            continue;
+        }
+
+        bool stall = (I.type == InstructionType::LOAD && isBusy(loadBusy, c)) ||
+            (I.type == InstructionType::STORE && isBusy(storeBusy, c));
+
+        if(!stall)
+            break;
+        markStall(c++);
+    }
+    t.memory = c;
+
+    // ALUs and the BEU are held through EX, ports through MM
+    switch(I.type){
+        case InstructionType::INTEGER:
+            intAluBusy[0] = t.execute;
+            intAluBusy[1] = t.memory;
+            break;
+        case InstructionType::FLOATING_POINT:
+            floatAluBusy[0] = t.execute;
+            floatAluBusy[1] = t.memory;
+            break;
+        case InstructionType::BRANCH:
+            beuBusy[0] = t.execute;
+            beuBusy[1] = t.memory;
+            branchResolved = t.memory;
+            break;
+        case InstructionType::LOAD:
+            loadBusy[0] = t.memory;
+            loadBusy[1] = t.memory + 1;
+            break;
+        case InstructionType::STORE:
+            storeBusy[0] = t.memory;
+            storeBusy[1] = t.memory + 1;
+            break;
+    }
+
+    // Nothing older can stall once I is in MM, so WB and retired follow in the next two cycles
+    t.retire = t.memory + 2;
+    return t;
+}
+
+/**
+ * Print the periodic reports of every report cycle up to and including cycle
+*/
+void EventSimulator::reportUpTo(long long cycle){
+    if(reportInterval <= 0)
+        return;
+    for(; nextReport <= cycle; nextReport += reportInterval)
+        if(verbose)
+            printSimulationReport(nextReport, simulatedStats);
+}
+
+/**
+ * Count I as retired in cycle, closing the previous retire cycle first
+*/
+void EventSimulator::retire(const Instruction &I, long long cycle){
+
+    if(cycle != lastRetireCycle){
+        long long retired = simulatedStats[0] + simulatedStats[1] + simulatedStats[2] + simulatedStats[3] + simulatedStats[4];
+        if(!warmedUp && retired >= warmupInstructions){
+            warmupCycle = lastRetireCycle;
+            warmupRetired = retired;
+            warmedUp = 1;
+        }
+
+        reportUpTo(cycle - 1);
+        lastRetireCycle = cycle;
+        retiredInCycle = 0;
+    }
+
+    retiredInCycle++;
+    simulatedStats[static_cast<int>(I.type)]++;
+    retireCycle[sequence % retireCycle.size()] = cycle;
+}
+
+/**
+ * Create a simulation using the parameters provided to the constructor
+*/
+void EventSimulator::simulate(){
+
+    if(verbose)
+        cout << "Starting Simulation...\n\n";
+
+    long long window = width * 5;
+
+    while(true){
+
+        // Keep width instructions read ahead so the retire limit near the end of the trace is known
+        while((int)pending.size() <= width && source->is_new_instruction_needed())
+            pending.push_back(source->get_next_instruction());
+
+        if(pending.empty())
+            break;
+
+        Instruction I = pending.front();
+        pending.pop_front();
+        long long remaining = source->is_new_instruction_needed() ? width : pending.size() + 1;
+
+        // The window is filled width instructions per cycle, after that an instruction enters
+        // in the cycle after the one width * 5 ahead of it is removed
+        long long enter = sequence < window ? sequence / width + 1 : retireCycle[(sequence - window) % retireCycle.size()] + 1;
+
+        stallBase = enter;
+
+        // Resolve dependencies before I becomes the newest producer of its own program_counter
+        for(int i = 0; i < I.dependencyCount; i++){
+            unordered_map<uint64_t, long long>::iterator producer = newestProducer.find(I.dependencies[i]);
+            producers[i] = producer != newestProducer.end() ? producer->second : NO_PRODUCER;
+        }
+        newestProducer[I.program_counter] = sequence;
+
+        Timing t = schedule(I, enter);
+
+        // At most width retire per cycle, fewer once fewer than width are left
+        long long cycle = max(t.retire, lastRetireCycle);
+        if(cycle == lastRetireCycle && retiredInCycle >= min((long long)width, remaining))
+            cycle++;
+
+        retire(I, cycle);
+        sequence++;
+    }
+
+    // Close the last retire cycle
+    long long retired = simulatedStats[0] + simulatedStats[1] + simulatedStats[2] + simulatedStats[3] + simulatedStats[4];
+    if(!warmedUp && retired >= warmupInstructions){
+        warmupCycle = lastRetireCycle;
+        warmupRetired = retired;
+        warmedUp = 1;
+    }
+    reportUpTo(lastRetireCycle);
+    clock = lastRetireCycle + 1;
+
+    if(!verbose)
+        return;
+
+    cout << "Simulation Results" << endl;
+    printSimulationReport(clock, simulatedStats);
+    cout << "Done exiting...\n";
+}
@@ -0,0 +1,96 @@
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "instruction.h"
+#include "InstructionSource.h"
+#include "Simulator.h"
+
+#ifndef EVENT_SIMULATOR_H_
+#define EVENT_SIMULATOR_H_
+
+/**
+ * Event-driven engine for the same in-order pipeline as Simulator
+ * Instead of advancing clock one cycle at a time and walking currentInstructions, each instruction
+ * is visited once, in program order, and the cycle of each of its stage transitions is computed
+ * from the older instructions' transition cycles. Only cycles in which an instruction waits in
+ * New, DE or EX are looked at individually; everything else is jumped over.
+ * Produces the same cycle counts, retired instruction mix and periodic reports as Simulator.
+*/
+class EventSimulator {
+  private:
+    // Transition cycles of one instruction
+    struct Timing {
+        long long decode;       // NW -> DE (fetch happens in the same cycle)
+        long long execute;      // DE -> EX
+        long long memory;       // EX -> MM
+        long long retire;       // removed from the pipeline window
+    };
+
+    unsigned short width;
+    InstructionSource *source;
+
+    // Instructions read ahead of the one being timed, so the tail of the trace is known
+    deque<Instruction> pending;
+
+    // Sequence number of the next instruction to be timed
+    long long sequence;
+
+    // Per dependency of that instruction, sequence number of the newest older instruction with its program_counter
+    uint64_t producers[TRACE_MAX_DEPENDENCIES];
+
+    // Removal cycle of the last width * 5 + 1 instructions, indexed by sequence number
+    vector<long long> retireCycle;
+
+    // program_counter -> sequence number of its newest instruction
+    unordered_map<uint64_t, long long> newestProducer;
+
+    // Cycles in which some instruction stalled, younger instructions can't move then
+    // Ring indexed by cycle, a slot holds the cycle it was marked for; only cycles from stallBase on are kept
+    vector<long long> stalls;
+    long long stallBase;
+
+    // Cycles a functional unit is held: [acquired, released)
+    long long intAluBusy[2], floatAluBusy[2], beuBusy[2], loadBusy[2], storeBusy[2];
+
+    // Cycle the newest branch finished EX, younger instructions can't be fetched before it
+    long long branchResolved;
+
+    // Last cycle with retirements and how many retired in it
+    long long lastRetireCycle;
+    int retiredInCycle;
+
+    long long simulatedStats[5];
+    long long clock;
+    long long reportInterval, nextReport;
+    bool verbose;
+
+    long long warmupInstructions, warmupCycle, warmupRetired;
+    bool warmedUp;
+
+    // Helper functions
+    bool stalledAt(long long cycle);
+    void markStall(long long cycle);
+    bool isBusy(const long long unit[2], long long cycle);
+    bool dependenciesInFlight(const Instruction &I, long long cycle);
+    Timing schedule(const Instruction &I, long long enter);
+    void retire(const Instruction &I, long long cycle);
+    void reportUpTo(long long cycle);
+
+  public:
+    // Constructor, source must outlive the EventSimulator
+    EventSimulator(InstructionSource&, unsigned short);
+
+    // The function that carries out the simulation
+    void simulate();
+
+    // Same meaning as the Simulator functions
+    void setVerbose(bool);
+
+    // Cycles between progress reports, 0 for none (default 200000, same as Simulator)
+    void setReportInterval(long long cycles);
+    void setWarmup(long long instructions);
+    SimulationResults getResults();
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include <fstream>
+#include <sstream>
+
+#include "FunctionalUnits.h"
+
+static const char *typeNames[5] = {"integer", "float", "branch", "load", "store"};
+
+FunctionalUnitConfig::FunctionalUnitConfig(){
+    for(int i = 0; i < 5; i++){
+        units[i].count = 1;
+        units[i].latency = 1;
+        units[i].pipelined = false;
+    }
+}
+
+bool FunctionalUnitConfig::isDefault() const{
+    for(int i = 0; i < 5; i++)
+        if(units[i].count != 1 || units[i].latency != 1)
+            return false;
+    return true;
+}
+
+bool FunctionalUnitConfig::isValid() const{
+    for(int i = 0; i < 5; i++)
+        if(units[i].count < 1 || units[i].latency < 1)
+            return false;
+    return true;
+}
+
+FunctionalUnitConfig FunctionalUnitConfig::clamped() const{
+    FunctionalUnitConfig config = *this;
+    for(int i = 0; i < 5; i++){
+        if(config.units[i].count < 1)
+            config.units[i].count = 1;
+        if(config.units[i].latency < 1)
+            config.units[i].latency = 1;
+    }
+    return config;
+}
+
+bool FunctionalUnitConfig::load(const std::string &path, std::string &error){
+
+    std::ifstream file(path);
+    if(!file){
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    for(int number = 1; getline(file, line); number++){
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        std::string type;
+        if(!(fields >> type))
+            continue;
+
+        int index = -1;
+        for(int i = 0; i < 5; i++)
+            if(type == typeNames[i])
+                index = i;
+
+        UnitConfig unit;
+        unit.pipelined = false;
+        std::string pipelined, extra;
+        bool ok = index >= 0 && fields >> unit.count >> unit.latency && unit.count >= 1 && unit.latency >= 1;
+        if(ok && fields >> pipelined)
+            ok = pipelined == "pipelined" || pipelined == "unpipelined";
+        ok = ok && !(fields >> extra);
+
+        if(!ok){
+            std::ostringstream message;
+            message << path << ":" << number << ": expected \"integer|float|branch|load|store count latency [pipelined]\"";
+            error = message.str();
+            return false;
+        }
+
+        unit.pipelined = pipelined == "pipelined";
+        units[index] = unit;
+    }
+
+    return true;
+}
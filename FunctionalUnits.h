@@ -0,0 +1,47 @@
+#include <string>
+
+#include "instruction.h"
+
+#ifndef FUNCTIONAL_UNITS_H_
+#define FUNCTIONAL_UNITS_H_
+
+/**
+ * Functional units serving one InstructionType
+ * Int/float ALUs and the BEU are held in EX, load and store ports in MM.
+ * A pipelined unit takes a new instruction every cycle and is only held for the cycle an instruction
+ * enters it; an unpipelined one is held until the instruction leaves the stage.
+*/
+struct UnitConfig {
+    int count;          // identical units, at least 1
+    int latency;        // cycles an instruction spends in the unit's stage, at least 1
+    bool pipelined;
+};
+
+/**
+ * Unit counts, latencies and pipelining per InstructionType
+ * Default: one unit of each kind with 1-cycle latency, the original fixed pipeline.
+*/
+struct FunctionalUnitConfig {
+    UnitConfig units[5];    // indexed by InstructionType
+
+    // Constructor, the default configuration
+    FunctionalUnitConfig();
+
+    // Whether this is the default configuration
+    bool isDefault() const;
+
+    // Whether every unit has a count and latency of at least 1
+    bool isValid() const;
+
+    // Copy with counts and latencies raised to at least 1
+    FunctionalUnitConfig clamped() const;
+
+    /**
+     * Reads "type count latency [pipelined]" lines, '#' starts a comment
+     * type is integer, float, branch, load or store; types not listed keep their default
+     * @param error description of the first bad line when returning false
+    */
+    bool load(const std::string &path, std::string &error);
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include <cstdio>
+#include <algorithm>
+
+#include "HotspotProfile.h"
+
+long long HotspotEntry::totalStalls() const{
+    long long total = 0;
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        total += stalls[i];
+    return total;
+}
+
+HotspotProfile::HotspotProfile(){
+    Slot empty = {0, HOTSPOT_FREE_SLOT};
+    slots.assign(HOTSPOT_INITIAL_SLOTS, empty);
+    shift = 64 - __builtin_ctzll(HOTSPOT_INITIAL_SLOTS);
+}
+
+// Put pc, which has no slot yet, into the first free one of its probe sequence
+void HotspotProfile::insert(uint64_t pc, uint32_t index){
+    size_t mask = slots.size() - 1;
+    size_t i = (pc * 0x9e3779b97f4a7c15ULL) >> shift;
+    while(slots[i].index != HOTSPOT_FREE_SLOT)
+        i = (i + 1) & mask;
+    slots[i].program_counter = pc;
+    slots[i].index = index;
+}
+
+/**
+ * Double the table and reinsert every PC, the counters stay where they are
+*/
+void HotspotProfile::grow(){
+
+    Slot empty = {0, HOTSPOT_FREE_SLOT};
+    slots.assign(slots.size() * 2, empty);
+    shift--;
+
+    for(size_t i = 0; i < entries.size(); i++)
+        insert(entries[i].program_counter, i);
+}
+
+size_t HotspotProfile::size() const{
+    return entries.size();
+}
+
+// Sort key of one entry: cycles first, ties by PC
+struct RankKey {
+    long long cycles;
+    uint64_t program_counter;
+    size_t index;
+};
+
+static bool outranks(const RankKey &a, const RankKey &b){
+    if(a.cycles != b.cycles)
+        return a.cycles > b.cycles;
+    return a.program_counter < b.program_counter;
+}
+
+/**
+ * The first limit entries, most stall cycles first or most blamed RAW cycles first
+ * Only the small keys are sorted, the entries themselves are copied once afterwards
+*/
+static vector<HotspotEntry> sortedEntries(const vector<HotspotEntry> &entries, bool byBlamed, size_t limit){
+
+    vector<RankKey> order(entries.size());
+    for(size_t i = 0; i < entries.size(); i++){
+        RankKey key = {byBlamed ? entries[i].blamed : entries[i].totalStalls(), entries[i].program_counter, i};
+        order[i] = key;
+    }
+    limit = min(limit, order.size());
+    partial_sort(order.begin(), order.begin() + limit, order.end(), outranks);
+
+    vector<HotspotEntry> sorted(limit);
+    for(size_t n = 0; n < limit; n++)
+        sorted[n] = entries[order[n].index];
+    return sorted;
+}
+
+vector<HotspotEntry> HotspotProfile::ranked() const{
+    return sortedEntries(entries, false, entries.size());
+}
+
+void HotspotProfile::printTop(int n, long long cycles) const{
+
+    vector<HotspotEntry> top = sortedEntries(entries, false, n);
+    int shown = (int)top.size();
+
+    printf("Hot spots: %d of %zu program counters with the most stall cycles\n", shown, entries.size());
+    printf("%-18s%-12s%-14s%-9s%-16s%s\n", "PC", "Retired", "Stall cycles", "% cycles", "Main cause", "Blamed RAW");
+    for(int i = 0; i < shown; i++){
+        const HotspotEntry &e = top[i];
+        int cause = 0;
+        for(int c = 1; c < STALL_CAUSE_COUNT; c++)
+            if(e.stalls[c] > e.stalls[cause])
+                cause = c;
+
+        long long stalled = e.totalStalls();
+        printf("%-18llx%-12lld%-14lld%-9.2f%-16s%lld\n", (unsigned long long)e.program_counter, e.retired, stalled,
+            cycles > 0 ? 100.0 * stalled / cycles : 0, stalled ? stallCauseName(cause) : "-", e.blamed);
+    }
+
+    top = sortedEntries(entries, true, n);
+    shown = 0;
+    while(shown < (int)top.size() && top[shown].blamed > 0)
+        shown++;
+
+    printf("\nProducers blamed for the most RAW stall cycles\n");
+    printf("%-18s%-12s%-14s%s\n", "PC", "Retired", "Blamed RAW", "% cycles");
+    for(int i = 0; i < shown; i++){
+        const HotspotEntry &e = top[i];
+        printf("%-18llx%-12lld%-14lld%.2f\n", (unsigned long long)e.program_counter, e.retired, e.blamed,
+            cycles > 0 ? 100.0 * e.blamed / cycles : 0);
+    }
+}
+
+bool HotspotProfile::writeCsv(const string &path) const{
+
+    FILE *file = fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    fprintf(file, "pc,retired,stall_cycles");
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        fprintf(file, ",%s", stallCauseName(i));
+    fprintf(file, ",blamed_raw\n");
+
+    vector<HotspotEntry> rows = ranked();
+    for(size_t n = 0; n < rows.size(); n++){
+        const HotspotEntry &e = rows[n];
+        fprintf(file, "%llx,%lld,%lld", (unsigned long long)e.program_counter, e.retired, e.totalStalls());
+        for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+            fprintf(file, ",%lld", e.stalls[i]);
+        fprintf(file, ",%lld\n", e.blamed);
+    }
+
+    return fclose(file) == 0;
+}
@@ -0,0 +1,95 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "instruction.h"
+#include "PipelineStats.h"
+
+#ifndef HOTSPOT_PROFILE_H_
+#define HOTSPOT_PROFILE_H_
+
+// Slots allocated up front, the table doubles whenever it is half full
+#define HOTSPOT_INITIAL_SLOTS 4096
+
+// Slot index of a free slot; every program counter, EMPTY_PROGRAM_COUNTER included, is a valid key
+#define HOTSPOT_FREE_SLOT UINT32_MAX
+
+// Counters of one program counter
+struct HotspotEntry {
+    uint64_t program_counter;
+    long long retired;
+    long long stalls[STALL_CAUSE_COUNT];    // cycles the pipeline stalled on an instruction with this PC, by cause
+    long long blamed;                       // RAW stall cycles of consumers waiting on a producer with this PC
+
+    long long totalStalls() const;
+};
+
+/**
+ * Per program counter profile of retirements and stall cycles
+ * Every stall cycle is counted once on the stalled instruction's PC, so the stall counters of all PCs
+ * add up to PipelineStats::stalls of a run simulated from its first cycle (checkpoints don't hold the profile,
+ * so it can't follow a restore); RAW stalls are also counted on the producer the consumer waited for.
+ * PCs are looked up in an open-addressing table with linear probing (a multiplicative hash of the PC
+ * picks the first slot) whose slots hold only the PC and the index of its counters, which are kept
+ * densely in the order PCs were first seen. Counting is a multiply and usually one probe in a flat
+ * array, empty slots cost 16 bytes, and growing the table moves only the slots.
+*/
+class HotspotProfile {
+  private:
+    struct Slot {
+        uint64_t program_counter;
+        uint32_t index;             // into entries, HOTSPOT_FREE_SLOT if free
+    };
+
+    std::vector<Slot> slots;
+    std::vector<HotspotEntry> entries;
+    int shift;          // 64 - log2(slots.size())
+
+    void grow();
+    void insert(uint64_t pc, uint32_t index);
+
+    // Entry of pc, added if it has none yet; defined here so the simulation loop can inline it
+    HotspotEntry &entry(uint64_t pc){
+        size_t mask = slots.size() - 1;
+        for(size_t i = (pc * 0x9e3779b97f4a7c15ULL) >> shift; ; i = (i + 1) & mask){
+            if(slots[i].index == HOTSPOT_FREE_SLOT)
+                break;
+            if(slots[i].program_counter == pc)
+                return entries[slots[i].index];
+        }
+
+        HotspotEntry added = HotspotEntry();
+        added.program_counter = pc;
+        entries.push_back(added);
+        if(2 * entries.size() > slots.size())
+            grow();
+        else
+            insert(pc, entries.size() - 1);
+        return entries.back();
+    }
+
+  public:
+    // Constructor
+    HotspotProfile();
+
+    void retire(uint64_t pc){ entry(pc).retired++; }
+    void stall(uint64_t pc, StallCause cause){ entry(pc).stalls[cause]++; }
+    void blame(uint64_t producerPc){ entry(producerPc).blamed++; }
+
+    // Number of distinct program counters seen
+    size_t size() const;
+
+    // Every entry, most stall cycles first
+    std::vector<HotspotEntry> ranked() const;
+
+    /**
+     * Prints the n PCs with the most stall cycles and the n producers blamed for the most RAW stall cycles
+     * @param cycles simulated cycles, to show the stall cycles as a share of the run
+    */
+    void printTop(int n, long long cycles) const;
+
+    // Writes one row per PC (most stall cycles first), returns false on failure
+    bool writeCsv(const std::string &path) const;
+};
+
+#endif
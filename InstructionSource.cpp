@@ -0,0 +1,58 @@
+#include "InstructionSource.h"
+
+Instruction recordToInstruction(const TraceRecord &record) {
+    Instruction instruction;
+    instruction.program_counter = record.program_counter;
+    instruction.type = static_cast<InstructionType>(record.type);
+
+    for (int i = 0; i < record.dependency_count; i++)
+        instruction.addDependency(record.dependencies[i]);
+
+    return instruction;
+}
+
+QueueSource::QueueSource(queue<Instruction> trace) {
+    this->trace.swap(trace);
+}
+
+// This function checks whether there are instructions left in the queue
+bool QueueSource::is_new_instruction_needed() {
+    return !trace.empty();
+}
+
+// This function pops and returns the front of the queue
+Instruction QueueSource::get_next_instruction() {
+    Instruction instruction = trace.front();
+    trace.pop();
+    return instruction;
+}
+
+RecordSource::RecordSource(const TraceRecord *records, size_t count) {
+    next = records;
+    end = records + count;
+}
+
+bool RecordSource::is_new_instruction_needed() {
+    return next != end;
+}
+
+// This function builds an Instruction out of the next record
+Instruction RecordSource::get_next_instruction() {
+    return recordToInstruction(*next++);
+}
+
+CallbackSource::CallbackSource(std::function<bool(TraceRecord&)> produce) {
+    this->produce = produce;
+    hasPending = this->produce(pending);
+}
+
+bool CallbackSource::is_new_instruction_needed() {
+    return hasPending;
+}
+
+// This function returns the record fetched ahead and fetches the next one
+Instruction CallbackSource::get_next_instruction() {
+    Instruction instruction = recordToInstruction(pending);
+    hasPending = produce(pending);
+    return instruction;
+}
@@ -0,0 +1,77 @@
+#include <queue>
+#include <functional>
+
+#include "instruction.h"
+#include "TraceParser.h"
+
+#ifndef INSTRUCTION_SOURCE_H_
+#define INSTRUCTION_SOURCE_H_
+
+// Builds the Instruction described by a decoded trace record
+Instruction recordToInstruction(const TraceRecord &record);
+
+/**
+ * Anything the Simulator can pull instructions from, one at a time, in program order
+*/
+class InstructionSource {
+  public:
+    virtual ~InstructionSource() {}
+
+    // Check if another instruction can be read
+    virtual bool is_new_instruction_needed() = 0;
+
+    // Reads and returns next instruction
+    virtual Instruction get_next_instruction() = 0;
+};
+
+/**
+ * Source over an already materialized queue of instructions
+*/
+class QueueSource : public InstructionSource {
+  private:
+    queue<Instruction> trace;
+
+  public:
+    // Constructor
+    QueueSource(queue<Instruction> trace);
+
+    bool is_new_instruction_needed();
+    Instruction get_next_instruction();
+};
+
+/**
+ * Source over a span of decoded trace records owned by someone else
+ * The records are never modified, so any number of RecordSources can share one buffer across threads
+*/
+class RecordSource : public InstructionSource {
+  private:
+    const TraceRecord *next;
+    const TraceRecord *end;
+
+  public:
+    // Constructor
+    RecordSource(const TraceRecord *records, size_t count);
+
+    bool is_new_instruction_needed();
+    Instruction get_next_instruction();
+};
+
+/**
+ * Source over a callback that produces one record per call, e.g. a generator or another reader
+ * The callback returns false once it has no more records; it is called one record ahead of the simulator.
+*/
+class CallbackSource : public InstructionSource {
+  private:
+    std::function<bool(TraceRecord&)> produce;
+    TraceRecord pending;
+    bool hasPending;
+
+  public:
+    // Constructor
+    CallbackSource(std::function<bool(TraceRecord&)> produce);
+
+    bool is_new_instruction_needed();
+    Instruction get_next_instruction();
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "InstructionWindow.h"
+
+/**
+ * Constructor
+ * @param capacity maximum number of instructions in flight
+*/
+InstructionWindow::InstructionWindow(int capacity){
+    this->capacity = capacity;
+    slots = vector<Instruction>(capacity);
+    head = count = 0;
+}
+
+Instruction& InstructionWindow::push_back(const Instruction &I){
+    Instruction &added = slots[slot(count)];
+    added = I;
+    count++;
+    return added;
+}
+
+void InstructionWindow::pop_front(){
+    head = slot(1);
+    count--;
+}
@@ -0,0 +1,45 @@
+#include <vector>
+
+#include "instruction.h"
+
+#ifndef INSTRUCTION_WINDOW_H_
+#define INSTRUCTION_WINDOW_H_
+
+/**
+ * Fixed-capacity circular buffer holding the instructions in flight, oldest first
+ * All slots are allocated up front; retiring the front and appending at the back are O(1)
+ * and reuse the slot's storage instead of moving the rest of the window.
+*/
+class InstructionWindow {
+  private:
+    vector<Instruction> slots;
+    int head, count, capacity;
+
+    // Slot holding the i-th oldest instruction
+    int slot(int i) const{
+        int index = head + i;
+        return index >= capacity ? index - capacity : index;
+    }
+
+  public:
+    // Constructor
+    InstructionWindow(int capacity = 0);
+
+    // Accessors are defined here so the simulation loop can inline them
+    int size() const{ return count; }
+    bool empty() const{ return count == 0; }
+    bool full() const{ return count == capacity; }
+
+    // i-th oldest instruction, 0 is the front
+    Instruction& at(int i){ return slots[slot(i)]; }
+    Instruction& front(){ return slots[head]; }
+    Instruction& back(){ return slots[slot(count - 1)]; }
+
+    // Copies I into the slot after the back and returns it, window must not be full
+    Instruction& push_back(const Instruction &I);
+
+    // Drops the oldest instruction, window must not be empty
+    void pop_front();
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include "OutOfOrderSimulator.h"
+
+#include <climits>
+
+/**
+ * Parameterized Constructor
+*/
+OutOfOrderSimulator::OutOfOrderSimulator(InstructionSource &source, unsigned short width, int robSize, int iqSize){
+    this->source = &source;
+    this->width = width;
+    this->robSize = robSize > 0 ? robSize : 32 * width;
+    this->iqSize = min(iqSize > 0 ? iqSize : 16 * width, this->robSize);
+
+    rob = vector<RobEntry>(this->robSize);
+    headSequence = nextSequence = 0;
+    iqCount = 0;
+
+    words = (this->robSize + 63) / 64;
+    ready = vector<uint64_t>(words, 0);
+    consumers = vector<uint64_t>((size_t)this->robSize * words, 0);
+
+    setUnits(FunctionalUnitConfig());
+    newestProducer = unordered_map<uint64_t, uint64_t>();
+
+    branchPending = 0;
+    branchSequence = 0;
+    branchResolved = 0;
+
+    simulatedStats[0] = simulatedStats[1] = simulatedStats[2] = simulatedStats[3] = simulatedStats[4] = 0;
+    clock = 1;
+    verbose = 1;
+    reportInterval = SIMULATOR_REPORT_INTERVAL;
+    setWarmup(0);
+}
+
+/**
+ * Size the unit pools and the wakeup ring, which must reach the longest issue-to-result distance
+*/
+void OutOfOrderSimulator::setUnits(const FunctionalUnitConfig &config){
+
+    units = config.clamped();
+    int longest = 1;
+    for(int i = 0; i < 5; i++){
+        unitFree[i] = vector<long long>(units.units[i].count, 0);
+        longest = max(longest, units.units[i].latency);
+    }
+
+    wakeups = vector<vector<int> >(longest + 2);
+    for(int i = 0; i < (int)wakeups.size(); i++)
+        wakeups[i].reserve(robSize);
+}
+
+void OutOfOrderSimulator::setVerbose(bool verbose){
+    this->verbose = verbose;
+}
+
+void OutOfOrderSimulator::setReportInterval(long long cycles){
+    reportInterval = cycles;
+}
+
+void OutOfOrderSimulator::setWarmup(long long instructions){
+    warmupInstructions = instructions;
+    warmupCycle = -1;
+    warmupRetired = 0;
+    warmedUp = instructions <= 0;
+}
+
+SimulationResults OutOfOrderSimulator::getResults(){
+
+    SimulationResults results;
+    results.width = width;
+    results.cycles = clock;
+    for(int i = 0; i < 5; i++)
+        results.retired[i] = simulatedStats[i];
+
+    results.measuredCycles = clock - 1 - warmupCycle;
+    results.measuredRetired = results.totalRetired() - warmupRetired;
+    return results;
+}
+
+OutOfOrderSimulator::RobEntry &OutOfOrderSimulator::entry(uint64_t sequence){
+    return rob[sequence % robSize];
+}
+
+/**
+ * Instance of a unit serving type that is free in cycle, -1 if all are busy
+*/
+int OutOfOrderSimulator::freeUnit(int type, long long cycle){
+    for(int i = 0; i < (int)unitFree[type].size(); i++)
+        if(unitFree[type][i] <= cycle)
+            return i;
+    return -1;
+}
+
+/**
+ * Deliver the results available from this cycle on: every consumer bit of a finished producer
+ * drops one pending operand, consumers left with none become ready
+*/
+void OutOfOrderSimulator::wakeup(){
+
+    vector<int> &due = wakeups[clock % wakeups.size()];
+
+    for(int i = 0; i < (int)due.size(); i++){
+        uint64_t *row = &consumers[(size_t)due[i] * words];
+        for(int w = 0; w < words; w++){
+            while(row[w]){
+                int bit = __builtin_ctzll(row[w]);
+                row[w] &= row[w] - 1;
+                if(--rob[w * 64 + bit].pending == 0)
+                    ready[w] |= 1ULL << bit;
+            }
+        }
+    }
+
+    due.clear();
+}
+
+/**
+ * Remove up to width finished instructions from the head of the reorder buffer, in program order
+*/
+void OutOfOrderSimulator::retire(){
+
+    for(int n = 0; n < width && headSequence < nextSequence; n++){
+        RobEntry &head = entry(headSequence);
+        if(!head.issued || head.retireCycle > clock)
+            return;
+
+        simulatedStats[(int)head.type]++;
+        headSequence++;
+    }
+}
+
+/**
+ * Select up to width ready instructions oldest first and start them on a free unit
+ * The ready vector is scanned from the head slot to the end and then from slot 0 up to the head;
+ * an instruction whose units are all busy stays ready and younger ones may go ahead of it
+*/
+void OutOfOrderSimulator::issue(){
+
+    int issued = 0;
+    int headSlot = headSequence % robSize;
+
+    for(int k = 0; k <= words && issued < width; k++){
+        int w = (headSlot / 64 + k) % words;
+        uint64_t bits = ready[w];
+        if(k == 0)
+            bits &= ~0ULL << (headSlot % 64);
+        else if(k == words)
+            bits &= ~(~0ULL << (headSlot % 64));
+
+        while(bits && issued < width){
+            int bit = __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            int slot = w * 64 + bit;
+            RobEntry &I = rob[slot];
+            int type = (int)I.type;
+            const UnitConfig &config = units.units[type];
+
+            // ALUs and the BEU are taken in EX, load/store ports in MM the cycle after
+            bool memory = I.type == InstructionType::LOAD || I.type == InstructionType::STORE;
+            long long unitCycle = clock + (memory ? 1 : 0);
+            int unit = freeUnit(type, unitCycle);
+            if(unit < 0)
+                continue;
+
+            unitFree[type][unit] = unitCycle + (config.pipelined ? 1 : config.latency);
+            ready[w] &= ~(1ULL << bit);
+            iqCount--;
+            issued++;
+
+            I.issued = 1;
+            I.resultCycle = unitCycle + config.latency;
+            I.retireCycle = clock + config.latency + 2;
+            wakeups[I.resultCycle % wakeups.size()].push_back(slot);
+
+            if(branchPending && (uint64_t)slot == branchSequence % robSize){
+                branchResolved = clock + config.latency;
+                branchPending = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Bring up to width instructions from source into the reorder buffer and issue queue
+ * Each dependency is resolved to the newest older instruction with that program_counter; if it is still
+ * in the reorder buffer without a result, the new instruction registers in its consumer bits
+*/
+void OutOfOrderSimulator::dispatch(){
+
+    for(int n = 0; n < width && source->is_new_instruction_needed(); n++){
+
+        // Fetch is blocked behind an unresolved branch, and needs room in both structures
+        if(branchPending || clock < branchResolved)
+            return;
+        if(nextSequence - headSequence == (uint64_t)robSize || iqCount == iqSize)
+            return;
+
+        Instruction I = source->get_next_instruction();
+        uint64_t sequence = nextSequence++;
+        int slot = sequence % robSize;
+        uint64_t bit = 1ULL << (slot % 64);
+
+        RobEntry &added = rob[slot];
+        added.type = I.type;
+        added.issued = 0;
+        added.pending = 0;
+        added.resultCycle = added.retireCycle = LLONG_MAX;
+
+        for(int d = 0; d < I.dependencyCount; d++){
+            unordered_map<uint64_t, uint64_t>::iterator producer = newestProducer.find(I.dependencies[d]);
+            if(producer == newestProducer.end() || producer->second < headSequence || entry(producer->second).resultCycle <= clock)
+                continue;
+
+            // Two dependencies on the same producer wait for one result
+            uint64_t &word = consumers[(size_t)(producer->second % robSize) * words + slot / 64];
+            if(!(word & bit)){
+                word |= bit;
+                added.pending++;
+            }
+        }
+        newestProducer[I.program_counter] = sequence;
+
+        if(added.pending == 0)
+            ready[slot / 64] |= bit;
+        iqCount++;
+
+        if(I.type == InstructionType::BRANCH){
+            branchPending = 1;
+            branchSequence = sequence;
+        }
+    }
+}
+
+/**
+ * Create a simulation using the parameters provided to the constructor
+ * Each cycle delivers results, retires, issues and then dispatches, so an instruction issues at the
+ * earliest the cycle after it was dispatched and consumers issue in the cycle its result is delivered
+*/
+void OutOfOrderSimulator::simulate(){
+
+    if(verbose)
+        cout << "Starting Simulation...\n\n";
+
+    while(true){
+        wakeup();
+        retire();
+        issue();
+        dispatch();
+
+        if(!warmedUp){
+            long long retired = simulatedStats[0] + simulatedStats[1] + simulatedStats[2] + simulatedStats[3] + simulatedStats[4];
+            if(retired >= warmupInstructions){
+                warmupCycle = clock;
+                warmupRetired = retired;
+                warmedUp = 1;
+            }
+        }
+
+        if(verbose && reportInterval > 0 && clock % reportInterval == 0)
+            printSimulationReport(clock, simulatedStats);
+
+        clock++;
+
+        if(headSequence == nextSequence && !source->is_new_instruction_needed())
+            break;
+    }
+
+    if(!verbose)
+        return;
+
+    cout << "Simulation Results" << endl;
+    printSimulationReport(clock, simulatedStats);
+    cout << "Done exiting...\n";
+}
@@ -0,0 +1,100 @@
+#include <vector>
+#include <unordered_map>
+
+#include "instruction.h"
+#include "InstructionSource.h"
+#include "FunctionalUnits.h"
+#include "Simulator.h"
+
+#ifndef OUT_OF_ORDER_SIMULATOR_H_
+#define OUT_OF_ORDER_SIMULATOR_H_
+
+/**
+ * Out-of-order core with the in-order pipeline's latencies
+ * Every cycle, up to width instructions are fetched and dispatched into the reorder buffer and issue
+ * queue (fetch stops behind a branch until it leaves EX), up to width operand-ready instructions issue
+ * oldest first to free functional units, and up to width finished instructions retire in order.
+ * An instruction issues no earlier than the cycle after dispatch; ALU and branch results are usable once
+ * the producer leaves EX, load/store results once it leaves MM, and it retires two cycles after that.
+ *
+ * Wakeup and select work on bit vectors over the reorder buffer, whose slot is sequence % robSize:
+ * ready has a bit per instruction waiting in the issue queue with all operands available, and
+ * consumers[slot] has a bit per instruction waiting on that slot's result. A result clears its consumers'
+ * pending counts, and select scans ready from the head slot, so the oldest ready instruction is found
+ * 64 entries at a time however large the window is.
+*/
+class OutOfOrderSimulator {
+  private:
+    struct RobEntry {
+        InstructionType type;
+        bool issued;
+        int pending;            // operands whose results are not available yet
+        long long resultCycle;  // first cycle consumers may issue, LLONG_MAX until issued
+        long long retireCycle;  // first cycle it may retire
+    };
+
+    unsigned short width;
+    int robSize, iqSize;
+    InstructionSource *source;
+
+    // Reorder buffer holds sequence numbers [headSequence, nextSequence)
+    vector<RobEntry> rob;
+    uint64_t headSequence, nextSequence;
+    int iqCount;
+
+    // Bit vectors over rob slots, words 64-bit words each
+    int words;
+    vector<uint64_t> ready;
+    vector<uint64_t> consumers;     // robSize rows
+
+    // wakeups[cycle % size]: slots whose result becomes available in that cycle
+    vector<vector<int> > wakeups;
+
+    // Cycle each unit instance is free again, per InstructionType
+    FunctionalUnitConfig units;
+    vector<long long> unitFree[5];
+
+    // program_counter -> sequence number of its newest instruction
+    unordered_map<uint64_t, uint64_t> newestProducer;
+
+    // Fetch waits for the newest branch: its sequence number while it hasn't issued, then the cycle it leaves EX
+    bool branchPending;
+    uint64_t branchSequence;
+    long long branchResolved;
+
+    long long simulatedStats[5];
+    long long clock;
+    long long reportInterval;
+    bool verbose;
+
+    long long warmupInstructions, warmupCycle, warmupRetired;
+    bool warmedUp;
+
+    // Helper functions
+    RobEntry &entry(uint64_t sequence);
+    void wakeup();
+    void retire();
+    void issue();
+    void dispatch();
+    int freeUnit(int type, long long cycle);
+
+  public:
+    /**
+     * Constructor, source must outlive the OutOfOrderSimulator
+     * @param robSize reorder buffer entries, 0 for 32 * width
+     * @param iqSize issue queue entries, 0 for 16 * width (at most robSize)
+    */
+    OutOfOrderSimulator(InstructionSource&, unsigned short width, int robSize = 0, int iqSize = 0);
+
+    // The function that carries out the simulation
+    void simulate();
+
+    // Same meaning as the Simulator functions
+    void setUnits(const FunctionalUnitConfig&);
+    void setVerbose(bool);
+    void setReportInterval(long long cycles);
+    void setWarmup(long long instructions);
+    SimulationResults getResults();
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include <cstdio>
+
+#include "PipelineStats.h"
+
+static const char *stallCauseNames[STALL_CAUSE_COUNT] = {"raw_alu", "raw_load_store", "int_alu_busy",
+    "float_alu_busy", "beu_busy", "load_port_busy", "store_port_busy", "fetch_branch"};
+
+static const char *typeNames[5] = {"integer", "floating_point", "branch", "load", "store"};
+
+static const char *stageNames[7] = {"NW", "IF", "DE", "EX", "MM", "WB", "RT"};
+
+const char *stallCauseName(int cause){
+    return cause >= 0 && cause < STALL_CAUSE_COUNT ? stallCauseNames[cause] : "unknown";
+}
+
+void PipelineStats::reset(unsigned short width){
+    this->width = width;
+    cycles = 0;
+    for(int i = 0; i < 5; i++)
+        retired[i] = 0;
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        stalls[i] = 0;
+    for(int i = 0; i < 7; i++)
+        stageOccupancy[i] = 0;
+    occupancy.assign(width * 5 + 1, 0);
+    retiredPerCycle.assign(width + 1, 0);
+}
+
+long long PipelineStats::totalRetired() const{
+    return retired[0] + retired[1] + retired[2] + retired[3] + retired[4];
+}
+
+long long PipelineStats::totalStalls() const{
+    long long total = 0;
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        total += stalls[i];
+    return total;
+}
+
+double PipelineStats::ipc() const{
+    return cycles > 0 ? (double)totalRetired() / cycles : 0;
+}
+
+/**
+ * Write the statistics as one JSON object
+ * @param path output file, replaced if it exists
+ * @returns false if the file can't be written
+*/
+bool PipelineStats::writeJson(const string &path) const{
+
+    FILE *file = fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    fprintf(file, "{\n  \"width\": %d,\n  \"cycles\": %lld,\n  \"retired\": %lld,\n  \"ipc\": %.6f,\n",
+        width, cycles, totalRetired(), ipc());
+
+    fprintf(file, "  \"retired_by_type\": {");
+    for(int i = 0; i < 5; i++)
+        fprintf(file, "%s\"%s\": %lld", i ? ", " : "", typeNames[i], retired[i]);
+
+    fprintf(file, "},\n  \"stall_cycles\": {");
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        fprintf(file, "%s\"%s\": %lld", i ? ", " : "", stallCauseNames[i], stalls[i]);
+
+    fprintf(file, "},\n  \"average_stage_occupancy\": {");
+    for(int i = 0; i < 7; i++)
+        fprintf(file, "%s\"%s\": %.6f", i ? ", " : "", stageNames[i], cycles > 0 ? (double)stageOccupancy[i] / cycles : 0);
+
+    fprintf(file, "},\n  \"occupancy_histogram\": [");
+    for(int i = 0; i < (int)occupancy.size(); i++)
+        fprintf(file, "%s%lld", i ? ", " : "", occupancy[i]);
+
+    fprintf(file, "],\n  \"retired_per_cycle_histogram\": [");
+    for(int i = 0; i < (int)retiredPerCycle.size(); i++)
+        fprintf(file, "%s%lld", i ? ", " : "", retiredPerCycle[i]);
+
+    fprintf(file, "]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+/**
+ * Write the statistics as section,key,value rows
+ * Sections: summary, retired, stall_cycles, stage_occupancy (average), occupancy and retired_per_cycle (histograms)
+ * @param path output file, replaced if it exists
+ * @returns false if the file can't be written
+*/
+bool PipelineStats::writeCsv(const string &path) const{
+
+    FILE *file = fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    fprintf(file, "section,key,value\n");
+    fprintf(file, "summary,width,%d\nsummary,cycles,%lld\nsummary,retired,%lld\nsummary,ipc,%.6f\n",
+        width, cycles, totalRetired(), ipc());
+
+    for(int i = 0; i < 5; i++)
+        fprintf(file, "retired,%s,%lld\n", typeNames[i], retired[i]);
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        fprintf(file, "stall_cycles,%s,%lld\n", stallCauseNames[i], stalls[i]);
+    for(int i = 0; i < 7; i++)
+        fprintf(file, "stage_occupancy,%s,%.6f\n", stageNames[i], cycles > 0 ? (double)stageOccupancy[i] / cycles : 0);
+    for(int i = 0; i < (int)occupancy.size(); i++)
+        fprintf(file, "occupancy,%d,%lld\n", i, occupancy[i]);
+    for(int i = 0; i < (int)retiredPerCycle.size(); i++)
+        fprintf(file, "retired_per_cycle,%d,%lld\n", i, retiredPerCycle[i]);
+
+    return fclose(file) == 0;
+}
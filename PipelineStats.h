@@ -0,0 +1,57 @@
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#ifndef PIPELINE_STATS_H_
+#define PIPELINE_STATS_H_
+
+// Why the in-order pipeline stopped advancing in a cycle
+enum StallCause {
+    STALL_RAW_ALU,          // decode waiting on an int/float/branch producer to finish EX
+    STALL_RAW_LOAD_STORE,   // decode waiting on a load/store producer to finish MEM
+    STALL_INT_ALU_BUSY,
+    STALL_FLOAT_ALU_BUSY,
+    STALL_BEU_BUSY,
+    STALL_LOAD_PORT_BUSY,   // execute waiting for the load port held by an older load in MEM
+    STALL_STORE_PORT_BUSY,
+    STALL_FETCH_BRANCH,     // fetch blocked behind an unresolved branch
+    STALL_CAUSE_COUNT
+};
+
+// Short snake_case name used in the exported files
+const char *stallCauseName(int cause);
+
+/**
+ * Per-cycle statistics of one simulation, collected only when enabled on the Simulator
+ * Every cycle stalls at most once (nothing younger than the stalled instruction moves),
+ * so the stall counters are cycles and add up to at most cycles.
+*/
+struct PipelineStats {
+    unsigned short width;
+    long long cycles;                       // as reported, the histograms cover the cycles - 1 simulated cycles
+    long long retired[5];                   // indexed by InstructionType
+    long long stalls[STALL_CAUSE_COUNT];    // cycles stalled by each cause
+
+    // occupancy[n]: cycles ending with n instructions in flight, 0 - width * 5
+    vector<long long> occupancy;
+
+    // retiredPerCycle[n]: cycles retiring n instructions, 0 - width
+    vector<long long> retiredPerCycle;
+
+    // Instructions in each InstructionStage summed over all cycles, divide by cycles for the average
+    long long stageOccupancy[7];
+
+    // Clears everything and sizes the histograms for width
+    void reset(unsigned short width);
+
+    long long totalRetired() const;
+    long long totalStalls() const;
+    double ipc() const;
+
+    // Export as JSON or as a long-format CSV (section,key,value), return false on failure
+    bool writeJson(const string &path) const;
+    bool writeCsv(const string &path) const;
+};
+
+#endif
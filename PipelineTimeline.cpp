@@ -0,0 +1,119 @@
+#include <cstring>
+
+#include "PipelineTimeline.h"
+
+static const char *typeNames[5] = {"int", "float", "branch", "load", "store"};
+
+PipelineTimeline::PipelineTimeline(){
+    file = NULL;
+    used = 0;
+    failed = false;
+    startCycle = 0;
+    endCycle = -1;
+}
+
+PipelineTimeline::~PipelineTimeline(){
+    close();
+}
+
+bool PipelineTimeline::open(const std::string &path, long long startCycle, long long endCycle){
+    close();
+
+    file = fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    buffer.resize(TIMELINE_BUFFER_SIZE);
+    used = 0;
+    failed = false;
+    this->startCycle = startCycle;
+    this->endCycle = endCycle;
+    return true;
+}
+
+void PipelineTimeline::flush(){
+    if(used != 0 && fwrite(buffer.data(), 1, used, file) != used)
+        failed = true;
+    used = 0;
+}
+
+void PipelineTimeline::append(const char *text, size_t length){
+    if(used + length > buffer.size())
+        flush();
+    memcpy(buffer.data() + used, text, length);
+    used += length;
+}
+
+void PipelineTimeline::appendDecimal(uint64_t value){
+    char digits[20];
+    int n = 0;
+    do {
+        digits[19 - n++] = '0' + value % 10;
+        value /= 10;
+    } while(value != 0);
+    append(digits + 20 - n, n);
+}
+
+void PipelineTimeline::appendHex(uint64_t value){
+    char digits[16];
+    int n = 0;
+    do {
+        digits[15 - n++] = "0123456789abcdef"[value & 15];
+        value >>= 4;
+    } while(value != 0);
+    append(digits + 16 - n, n);
+}
+
+/**
+ * Appends "O3PipeView:<stage>:<tick>\n"
+*/
+void PipelineTimeline::appendStage(const char *stage, size_t length, long long cycle){
+    append("O3PipeView:", 11);
+    append(stage, length);
+    append(":", 1);
+    appendDecimal((uint64_t)cycle * TIMELINE_TICKS_PER_CYCLE);
+    append("\n", 1);
+}
+
+void PipelineTimeline::write(const Instruction &I, uint64_t sequence, const long long stageCycles[7]){
+
+    long long fetched = stageCycles[(int)InstructionStage::IF], retired = stageCycles[(int)InstructionStage::RT];
+    if(file == NULL || retired < startCycle || (endCycle >= 0 && fetched > endCycle))
+        return;
+
+    // fetch line carries pc, micro-op index, sequence number and a disassembly stand-in
+    append("O3PipeView:fetch:", 17);
+    appendDecimal((uint64_t)fetched * TIMELINE_TICKS_PER_CYCLE);
+    append(":0x", 3);
+    appendHex(I.program_counter);
+    append(":0:", 3);
+    appendDecimal(sequence + 1);
+    append(":", 1);
+    const char *type = typeNames[(int)I.type];
+    append(type, strlen(type));
+    append("\n", 1);
+
+    long long decoded = stageCycles[(int)InstructionStage::DE];
+    appendStage("decode", 6, decoded);
+    appendStage("rename", 6, decoded);
+    appendStage("dispatch", 8, decoded);
+    appendStage("issue", 5, stageCycles[(int)InstructionStage::EX]);
+    appendStage("complete", 8, stageCycles[(int)InstructionStage::WB]);
+
+    append("O3PipeView:retire:", 18);
+    appendDecimal((uint64_t)retired * TIMELINE_TICKS_PER_CYCLE);
+    append(":store:", 7);
+    appendDecimal(I.type == InstructionType::STORE ? (uint64_t)stageCycles[(int)InstructionStage::MM] * TIMELINE_TICKS_PER_CYCLE : 0);
+    append("\n", 1);
+}
+
+bool PipelineTimeline::close(){
+    if(file == NULL)
+        return !failed;
+
+    flush();
+    if(fclose(file) != 0)
+        failed = true;
+    file = NULL;
+    return !failed;
+}
@@ -0,0 +1,58 @@
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "instruction.h"
+
+#ifndef PIPELINE_TIMELINE_H_
+#define PIPELINE_TIMELINE_H_
+
+// gem5's default tick rate, what o3-pipeview.py and Konata expect
+#define TIMELINE_TICKS_PER_CYCLE 1000
+
+// Output buffer, written out whenever it fills up
+#define TIMELINE_BUFFER_SIZE (4 << 20)
+
+/**
+ * Writes retired instructions in gem5's O3PipeView format, readable by o3-pipeview.py and Konata
+ * Stages map to fetch (IF), decode/rename/dispatch (DE), issue (EX), complete (WB) and retire (RT);
+ * stores also get their MM cycle as the store completion tick.
+ * Lines are formatted by hand into one large buffer, so logging costs a few hundred bytes of memcpy per instruction.
+*/
+class PipelineTimeline {
+  private:
+    FILE *file;
+    std::vector<char> buffer;
+    size_t used;
+    bool failed;
+
+    // Only instructions in flight at some point in [startCycle, endCycle] are written, endCycle < 0 for no end
+    long long startCycle, endCycle;
+
+    void append(const char *text, size_t length);
+    void appendDecimal(uint64_t value);
+    void appendHex(uint64_t value);
+    void appendStage(const char *stage, size_t length, long long cycle);
+    void flush();
+
+  public:
+    // Constructor
+    PipelineTimeline();
+    ~PipelineTimeline();
+
+    // Creates path, returns false on failure
+    bool open(const std::string &path, long long startCycle, long long endCycle);
+
+    /**
+     * Writes one retired instruction
+     * @param I the instruction
+     * @param sequence I's position in program order, used as the O3PipeView sequence number
+     * @param stageCycles cycle I entered each InstructionStage, indexed by stage
+    */
+    void write(const Instruction &I, uint64_t sequence, const long long stageCycles[7]);
+
+    // Flushes and closes the file, returns false if anything failed to be written
+    bool close();
+};
+
+#endif
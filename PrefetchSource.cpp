@@ -0,0 +1,84 @@
+#include "PrefetchSource.h"
+
+PrefetchSource::PrefetchSource(TraceInput &input)
+    : input(input), batches(PREFETCH_BATCHES), filled(PREFETCH_BATCHES), emptied(PREFETCH_BATCHES){
+
+    for(int i = 0; i < PREFETCH_BATCHES; i++){
+        batches[i].records.resize(PREFETCH_BATCH_SIZE);
+        batches[i].count = 0;
+        batches[i].last = false;
+        emptied.push(i);
+    }
+
+    current = -1;
+    position = 0;
+    finished = false;
+    stopping = false;
+
+    reader = std::thread(&PrefetchSource::readAhead, this);
+}
+
+PrefetchSource::~PrefetchSource(){
+    stopping = true;
+    reader.join();
+}
+
+/**
+ * Reader thread: fill every emptied batch until input runs out or the source is destroyed
+*/
+void PrefetchSource::readAhead(){
+
+    while(!stopping){
+        int index;
+        while(!emptied.pop(index)){
+            if(stopping)
+                return;
+            std::this_thread::yield();
+        }
+
+        Batch &batch = batches[index];
+        batch.count = 0;
+        while(batch.count < PREFETCH_BATCH_SIZE && input.is_new_instruction_needed())
+            input.get_next_record(batch.records[batch.count++]);
+        batch.last = !input.is_new_instruction_needed();
+
+        // Never full, there are only as many batches as slots
+        filled.push(index);
+
+        if(batch.last)
+            return;
+    }
+}
+
+/**
+ * Give the current batch back to the reader, or wait for the next filled one
+*/
+void PrefetchSource::advance(){
+
+    if(current >= 0){
+        finished = batches[current].last;
+        emptied.push(current);
+        current = -1;
+        return;
+    }
+
+    while(!filled.pop(current))
+        std::this_thread::yield();
+    position = 0;
+}
+
+bool PrefetchSource::is_new_instruction_needed(){
+
+    while(true){
+        if(current >= 0 && position < batches[current].count)
+            return true;
+        if(finished)
+            return false;
+        advance();
+    }
+}
+
+Instruction PrefetchSource::get_next_instruction(){
+    is_new_instruction_needed();
+    return recordToInstruction(batches[current].records[position++]);
+}
@@ -0,0 +1,55 @@
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "InstructionSource.h"
+#include "ReadInput.h"
+#include "SpscRing.h"
+
+#ifndef PREFETCH_SOURCE_H_
+#define PREFETCH_SOURCE_H_
+
+// Records per batch and batches in flight, bounding the read-ahead to about 1.5 MB
+#define PREFETCH_BATCH_SIZE 4096
+#define PREFETCH_BATCHES 8
+
+/**
+ * Source that parses a TraceInput on its own thread while the simulator consumes it
+ * The reader fills preallocated batches of TraceRecords and hands them over through one SpscRing;
+ * the simulator hands emptied batches back through another, so nothing is allocated after construction
+ * and parsing overlaps with simulation.
+*/
+class PrefetchSource : public InstructionSource {
+  private:
+    struct Batch {
+        std::vector<TraceRecord> records;
+        int count;
+        bool last;      // nothing follows this batch
+    };
+
+    TraceInput &input;
+    std::vector<Batch> batches;
+
+    // Indices into batches: filled ones to the simulator, emptied ones back to the reader
+    SpscRing<int> filled, emptied;
+
+    std::thread reader;
+    std::atomic<bool> stopping;
+
+    // Batch being consumed (-1 for none), next record in it, and whether the last batch was consumed
+    int current, position;
+    bool finished;
+
+    void readAhead();
+    void advance();
+
+  public:
+    // Constructor, starts reading input, which must not be used by anyone else until this is destroyed
+    PrefetchSource(TraceInput &input);
+    ~PrefetchSource();
+
+    bool is_new_instruction_needed();
+    Instruction get_next_instruction();
+};
+
+#endif
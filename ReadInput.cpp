@@ -1,6 +1,12 @@
 #include "ReadInput.h"
+#include "TraceIndex.h"
 
-TraceInput::TraceInput(string trace_file_name, int start_inst, int inst_count) {
+#include <chrono>
+
+// Written by measure_parse() so the decode loop can't be optimized away
+volatile uint64_t parse_sink;
+
+TraceInput::TraceInput(string trace_file_name, long long start_inst, long long inst_count) {
     this->trace_file_path = trace_file_name;
     this->start_inst = start_inst;
     this->inst_count = inst_count;
@@ -10,74 +16,103 @@ TraceInput::TraceInput(string trace_file_name, int start_inst, int inst_count) {
 }
 
 void TraceInput::prepare_file() {
-    string line;
-    trace_file.open(trace_file_path);
-    if (trace_file.is_open()) {
+    if (parser.open(trace_file_path)) {
         // skip lines until start_inst is reached
-        int i;
-        for (i = 1; i < start_inst; i++) {
-            getline(trace_file, line);
-            if (trace_file.eof()) {
+        // Binary traces seek directly, compressed ones can only be read through
+        if (parser.is_binary() || parser.is_compressed()) {
+            if (!parser.skip_lines(start_inst - 1)) {
                 file_failed = true;
                 return;
             }
+        } else if (!skip_with_index(start_inst - 1)) {
+            file_failed = true;
+            return;
         }
 
         // Shlok Koirala: Set curr_line
-        curr_line = i;
+        curr_line = start_inst;
         
     } else {
         file_failed = true;
     }
 }
 
+/**
+ * Skip the first lines of a text trace, seeking through the sidecar index where it reaches
+ * Stride boundaries passed on the way are added to the index for later runs
+ * @returns false if the trace has fewer lines
+*/
+bool TraceInput::skip_with_index(uint64_t lines) {
+    if (lines == 0)
+        return true;
+
+    TraceIndex index(trace_file_path);
+
+    uint64_t offset;
+    uint64_t line = index.lookup(lines, offset);
+    if (line != 0 && !parser.seek(offset, line))
+        return false;
+
+    while (line < lines) {
+        uint64_t step = min(lines - line, TRACE_INDEX_STRIDE - line % TRACE_INDEX_STRIDE);
+        // Keep what was indexed so far, a window reaching past the end is often retried
+        if (!parser.skip_lines(step)) {
+            index.save();
+            return false;
+        }
+
+        line += step;
+        index.record(line, parser.bytes_read());
+    }
+
+    index.save();
+    return true;
+}
+
 // This function checks whether a new instruction is needed or not
 bool TraceInput::is_new_instruction_needed() {
     return curr_line < start_inst + inst_count;
 }
 
 
-// This function reads the next line of the trace file and returns an Instruction object
-Instruction TraceInput::get_next_instruction() {
-    if (!trace_file.is_open() || trace_file.eof()) {
-        cerr << "Error: file not open or end of file reached\n";
+// This function reads the next line of the trace file into record
+void TraceInput::get_next_record(TraceRecord &record) {
+    if (!parser.next(record)) {
+        if (parser.malformed)
+            cerr << "Error: invalid line format\n";
+        else
+            cerr << "Error: file not open or end of file reached\n";
         exit(1);
     }
-
-    string line;
-    getline(trace_file, line);
     curr_line++;
+}
 
-    vector<string> tokens;
-    stringstream ss(line);
-    string token;
-    while (getline(ss, token, ',')) {
-        tokens.push_back(token);
-    }
-
-    if (tokens.size() < 2) {
-        cerr << "Error: invalid line format\n";
-        exit(1);
-    }
-
-    Instruction instruction;
-    instruction.program_counter = tokens[0];
-
-    // Shlok Koirala: added -1 to match enum indexing
-    int type = stoi(tokens[1]) - 1;
-    instruction.type = static_cast<InstructionType>(type);
+bool TraceInput::try_next_record(TraceRecord &record) {
+    if (!parser.next(record))
+        return false;
+    curr_line++;
+    return true;
+}
 
-    
-    for (int i = 2; i < static_cast<int>(tokens.size()); i++) {
-        instruction.addDependency(tokens[i]);
-    }
+// This function reads the next line of the trace file and returns an Instruction object
+Instruction TraceInput::get_next_instruction() {
+    TraceRecord record;
+    get_next_record(record);
 
-    return instruction;
+    return recordToInstruction(record);
 }
 
 // This function closes the trace file
 void TraceInput::close_file() {
-    trace_file.close();
+    parser.close();
+}
+
+bool TraceInput::is_binary() {
+    return parser.is_binary();
+}
+
+bool TraceInput::is_compressed() {
+    return parser.is_compressed();
 }
 
 /**
@@ -95,4 +130,99 @@ queue<Instruction> TraceInput::getTrace(){
     close_file();
     
     return trace;
-}
\ No newline at end of file
+}
+
+/**
+ * Decode the whole window into records, e.g. to share one parsed trace between simulations
+ * @returns records of every remaining instruction
+*/
+vector<TraceRecord> TraceInput::getRecords(){
+
+    vector<TraceRecord> records;
+    records.reserve(start_inst + inst_count - curr_line);
+
+    TraceRecord record;
+    while(is_new_instruction_needed()){
+        get_next_record(record);
+        records.push_back(record);
+    }
+
+    close_file();
+
+    return records;
+}
+
+double ParseThroughput::mb_per_sec() {
+    return seconds > 0 ? bytes / seconds / 1e6 : 0;
+}
+
+double ParseThroughput::lines_per_sec() {
+    return seconds > 0 ? lines / seconds : 0;
+}
+
+/**
+ * Decode every remaining instruction of the window, timing only the parser
+ * @returns bytes and lines parsed and the time it took
+*/
+ParseThroughput TraceInput::measure_parse() {
+    ParseThroughput result;
+    uint64_t bytes = parser.bytes_read(), lines = parser.lines_read();
+
+    TraceRecord record;
+    uint64_t checksum = 0;
+    auto begin = chrono::steady_clock::now();
+    while (is_new_instruction_needed()) {
+        get_next_record(record);
+        checksum += record.program_counter + record.dependency_count;
+    }
+    auto done = chrono::steady_clock::now();
+
+    result.seconds = chrono::duration<double>(done - begin).count();
+    result.bytes = parser.bytes_read() - bytes;
+    result.lines = parser.lines_read() - lines;
+
+    // keep the loop from being optimized away
+    parse_sink = checksum;
+
+    return result;
+}
+
+/**
+ * Decode the same window with the original line reader: getline, stringstream and a string per token
+ * @returns bytes and lines parsed and the time it took (skipping to start_inst is not timed)
+*/
+ParseThroughput TraceInput::measure_legacy_parse(string trace_file_path, long long start_inst, long long inst_count) {
+    ParseThroughput result;
+    result.seconds = 0;
+    result.bytes = result.lines = 0;
+
+    ifstream trace_file(trace_file_path);
+    string line;
+    for (long long i = 1; i < start_inst && getline(trace_file, line); i++)
+        ;
+
+    auto begin = chrono::steady_clock::now();
+    for (long long n = 0; n < inst_count && getline(trace_file, line); n++) {
+        vector<string> tokens;
+        stringstream ss(line);
+        string token;
+        while (getline(ss, token, ','))
+            tokens.push_back(token);
+
+        if (tokens.size() < 2)
+            break;
+
+        Instruction instruction;
+        instruction.program_counter = stoull(tokens[0], NULL, 16);
+        instruction.type = static_cast<InstructionType>(stoi(tokens[1]) - 1);
+        for (int i = 2; i < static_cast<int>(tokens.size()); i++)
+            instruction.addDependency(stoull(tokens[i], NULL, 16));
+
+        result.bytes += line.size() + 1;
+        result.lines++;
+    }
+    auto done = chrono::steady_clock::now();
+
+    result.seconds = chrono::duration<double>(done - begin).count();
+    return result;
+}
@@ -6,21 +6,36 @@
 #include <sstream>
 
 #include "instruction.h"
+#include "InstructionSource.h"
+#include "TraceParser.h"
 
 #ifndef TRACE_INPUT_H_
 #define TRACE_INPUT_H_
 
-class TraceInput {
+// Parse timing for one pass over a trace window
+struct ParseThroughput {
+    double seconds;
+    uint64_t bytes;
+    uint64_t lines;
+
+    double mb_per_sec();
+    double lines_per_sec();
+};
+
+class TraceInput : public InstructionSource {
   private:
     std::string trace_file_path;
-    int start_inst;
-    int inst_count;
-    int curr_line;
-    std::ifstream trace_file;
+    long long start_inst;
+    long long inst_count;
+    long long curr_line;
+    TraceParser parser;
+
+    // Skips lines of a text trace using its sidecar index
+    bool skip_with_index(uint64_t lines);
     
   public:
     // Constructor
-    TraceInput(std::string trace_file_path, int start_inst_index, int inst_count);
+    TraceInput(std::string trace_file_path, long long start_inst_index, long long inst_count);
 
     bool file_failed;
     
@@ -33,11 +48,33 @@ class TraceInput {
     // Reads and returns next instruction
     Instruction get_next_instruction();
 
+    // Reads next line as plain integers, no Instruction is built
+    void get_next_record(TraceRecord &record);
+
+    // Same as get_next_record() but returns false at the end of the file or on a malformed line instead of exiting
+    bool try_next_record(TraceRecord &record);
+
+    // Returns every remaining record of the window as plain integers
+    std::vector<TraceRecord> getRecords();
+
     // Returns queue with all instructions
+    // Note: materializes the whole window, prefer passing the TraceInput to Simulator directly
     queue<Instruction> getTrace();
     
     // Closes file
     void close_file();
+
+    // Whether the trace was detected as the binary format
+    bool is_binary();
+
+    // Whether the trace is decompressed while reading
+    bool is_compressed();
+
+    // Decodes the rest of the window without simulating it
+    ParseThroughput measure_parse();
+
+    // Same window through the original getline/stringstream/stoi reader, for comparison
+    static ParseThroughput measure_legacy_parse(std::string trace_file_path, long long start_inst, long long inst_count);
 };
 
 #endif
@@ -0,0 +1,205 @@
+#include "Sampling.h"
+#include "EventSimulator.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+vector<SamplePoint> systematicSamples(long long start, long long count, long long length, long long period){
+
+    vector<SamplePoint> points;
+
+    for(long long s = start; s < start + count; s += period){
+        SamplePoint point;
+        point.start = s;
+        point.length = min(length, start + count - s);
+        point.weight = point.length;
+        points.push_back(point);
+    }
+
+    return points;
+}
+
+bool parseSamplePoints(const string &list, long long length, vector<SamplePoint> &points){
+
+    points.clear();
+    stringstream ss(list);
+    string item;
+
+    while(getline(ss, item, ',')){
+        size_t colon = item.find(':');
+
+        SamplePoint point;
+        point.start = atoll(item.substr(0, colon).c_str());
+        point.length = length;
+        point.weight = colon == string::npos ? 1 : atof(item.substr(colon + 1).c_str());
+
+        if(point.start <= 0 || point.weight <= 0)
+            return false;
+        points.push_back(point);
+    }
+
+    return !points.empty();
+}
+
+/**
+ * Simulate source quietly, the first warmup instructions are not measured
+*/
+template<class Engine>
+static SimulationResults runWarmedUp(InstructionSource &source, unsigned short width, long long warmup){
+    Engine simulator(source, width);
+    simulator.setVerbose(0);
+    simulator.setWarmup(warmup);
+    simulator.simulate();
+    return simulator.getResults();
+}
+
+/**
+ * Simulate one interval after its warmup prefix
+*/
+static SampleResult runSample(const string &traceFile, const SamplePoint &point, long long warmup,
+    long long firstInst, unsigned short width, bool eventEngine){
+
+    SampleResult result;
+    result.point = point;
+    result.cycles = result.retired = 0;
+
+    long long prefix = min(warmup, point.start - firstInst);
+    if(prefix < 0)
+        prefix = 0;
+
+    TraceInput trace(traceFile, point.start - prefix, prefix + point.length);
+    result.failed = trace.file_failed;
+    if(result.failed)
+        return result;
+
+    // Read through CallbackSource so an interval running past the end of the trace (or into a malformed
+    // line) fails this sample instead of exiting like TraceInput::get_next_instruction() would
+    long long remaining = prefix + point.length;
+    bool truncated = false;
+    CallbackSource source([&](TraceRecord &record){
+        if(remaining == 0)
+            return false;
+        if(!trace.try_next_record(record)){
+            truncated = true;
+            return false;
+        }
+        remaining--;
+        return true;
+    });
+
+    SimulationResults totals = eventEngine ? runWarmedUp<EventSimulator>(source, width, prefix) :
+        runWarmedUp<Simulator>(source, width, prefix);
+    result.failed = truncated;
+    result.cycles = totals.measuredCycles;
+    result.retired = totals.measuredRetired;
+    return result;
+}
+
+/**
+ * Run the intervals on a pool of threads, each thread takes the next unclaimed interval
+ * @returns one result per point, same order as points
+*/
+vector<SampleResult> runSamples(const string &traceFile, const vector<SamplePoint> &points, long long warmup,
+    long long firstInst, unsigned short width, int threads, bool eventEngine){
+
+    vector<SampleResult> results(points.size());
+    atomic<size_t> next(0);
+
+    if(threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    vector<thread> pool;
+    for(int t = 0; t < threads && t < (int)points.size(); t++){
+        pool.push_back(thread([&](){
+            for(size_t i = next++; i < points.size(); i = next++)
+                results[i] = runSample(traceFile, points[i], warmup, firstInst, width, eventEngine);
+        }));
+    }
+
+    for(int t = 0; t < (int)pool.size(); t++)
+        pool[t].join();
+
+    return results;
+}
+
+/**
+ * Combine per-interval CPI into an estimate for the whole range
+ * @param instructions number of instructions the samples stand for
+ * @param systematic samples are evenly spaced over the range (finite population correction applies)
+*/
+SamplingEstimate estimateFromSamples(const vector<SampleResult> &results, long long instructions, bool systematic){
+
+    SamplingEstimate estimate;
+    estimate.samples = 0;
+    estimate.instructions = instructions;
+    estimate.cpi = estimate.cycles = estimate.ipc = 0;
+    estimate.cpiStdError = estimate.relativeError = 0;
+
+    double weights = 0, weights2 = 0, weightedCpi = 0;
+    long long sampled = 0;
+    for(int i = 0; i < (int)results.size(); i++){
+        if(results[i].failed || results[i].retired == 0)
+            continue;
+
+        double w = results[i].point.weight;
+        weights += w;
+        weights2 += w * w;
+        weightedCpi += w * results[i].cycles / results[i].retired;
+        sampled += results[i].retired;
+        estimate.samples++;
+    }
+
+    if(estimate.samples == 0)
+        return estimate;
+
+    estimate.cpi = weightedCpi / weights;
+    estimate.cycles = estimate.cpi * instructions;
+    estimate.ipc = 1 / estimate.cpi;
+
+    if(estimate.samples > 1){
+        // Weighted sample variance of the per-interval CPI
+        double variance = 0;
+        for(int i = 0; i < (int)results.size(); i++){
+            if(results[i].failed || results[i].retired == 0)
+                continue;
+            double d = (double)results[i].cycles / results[i].retired - estimate.cpi;
+            variance += results[i].point.weight * d * d;
+        }
+        variance /= weights - weights2 / weights;
+
+        // Standard error of the weighted mean, with the effective number of samples
+        double effective = weights * weights / weights2;
+        double fpc = systematic && sampled < instructions ? 1 - (double)sampled / instructions : 1;
+        if(systematic && sampled >= instructions)
+            fpc = 0;
+
+        estimate.cpiStdError = sqrt(variance / effective * fpc);
+        estimate.relativeError = 1.96 * estimate.cpiStdError / estimate.cpi;
+    }
+
+    return estimate;
+}
+
+void printSamplingReport(const vector<SampleResult> &results, SamplingEstimate &estimate){
+
+    printf("Start\t\tInstructions\tCycles\t\tCPI\n");
+    for(int i = 0; i < (int)results.size(); i++){
+        const SampleResult &r = results[i];
+        if(r.failed){
+            printf("%lld\t\tfailed to read trace\n", r.point.start);
+            continue;
+        }
+        printf("%lld\t\t%lld\t\t%lld\t\t%.4f\n", r.point.start, r.retired, r.cycles,
+            r.retired ? (double)r.cycles / r.retired : 0.0);
+    }
+
+    cout << "\nSampled Estimate (" << estimate.samples << " intervals, " << estimate.instructions << " instructions)\n";
+    printf("Estimated clock cycles:\t\t%.0f\n", estimate.cycles);
+    printf("Estimated IPC:\t\t\t%.4f\n", estimate.ipc);
+    printf("CPI:\t\t\t\t%.4f +/- %.4f (95%% confidence, %.2f%%)\n", estimate.cpi,
+        1.96 * estimate.cpiStdError, 100 * estimate.relativeError);
+}
@@ -0,0 +1,56 @@
+#include <string>
+#include <vector>
+
+#include "Simulator.h"
+
+#ifndef SAMPLING_H_
+#define SAMPLING_H_
+
+// One simulated interval of the trace, start is a 1-based instruction number
+struct SamplePoint {
+    long long start;
+    long long length;
+    double weight;
+};
+
+// Measured part of one interval, warmup excluded
+struct SampleResult {
+    SamplePoint point;
+    long long cycles;
+    long long retired;
+    bool failed;
+};
+
+// Whole-range numbers extrapolated from the samples
+struct SamplingEstimate {
+    int samples;
+    long long instructions;     // size of the range being estimated
+    double cpi;
+    double cycles;
+    double ipc;
+    double cpiStdError;         // standard error of cpi
+    double relativeError;       // 95% confidence half-width relative to cpi
+};
+
+/**
+ * Fixed-size intervals of length instructions, one starting every period instructions of [start, start + count)
+ * period == length covers the whole range
+*/
+vector<SamplePoint> systematicSamples(long long start, long long count, long long length, long long period);
+
+// Parses user-selected intervals "start[:weight],...", each length instructions long
+bool parseSamplePoints(const string &list, long long length, vector<SamplePoint> &points);
+
+/**
+ * Simulates every interval with its own TraceInput and Simulator (EventSimulator if eventEngine), threads at a time
+ * Each interval is preceded by up to warmup instructions (never before instruction firstInst) to fill the pipeline
+*/
+vector<SampleResult> runSamples(const string &traceFile, const vector<SamplePoint> &points, long long warmup,
+    long long firstInst, unsigned short width, int threads, bool eventEngine = false);
+
+// Weighted mean CPI over the samples and its error, extrapolated to instructions
+SamplingEstimate estimateFromSamples(const vector<SampleResult> &results, long long instructions, bool systematic);
+
+void printSamplingReport(const vector<SampleResult> &results, SamplingEstimate &estimate);
+
+#endif
@@ -1,47 +1,447 @@
 # include "Simulator.h"
 # include "instruction.h"
 
+# include <csignal>
+# include <climits>
+
+// Set by requestCheckpoint(), cleared once a checkpoint is saved
+static volatile sig_atomic_t checkpointRequested = 0;
+
 
 /**
- * Frees resource occupied by I
- * @param I Instruction whose resource is to be freed
+ * Occupy one of the units serving I's type
+ * @param I instruction entering the unit's stage
+ * @return false (and count the stall) if all of them are busy
 */
-void Simulator::freeResource(Instruction I){
-
-    switch(I.type){
-        
-        case static_cast<InstructionType>(0):
-            isIntAluIdle = 1;
-            return;
-        case static_cast<InstructionType>(1):
-            isFloatAluIdle = 1;
-            return;
-        case static_cast<InstructionType>(2):
-            isBeuIdle = 1;
-            runningBranch = 0;
-            return;
-        case static_cast<InstructionType>(3):
-            isLoadIdle = 1;
-            return;
-        case static_cast<InstructionType>(4):
-            isStoreIdle = 1;
-            return;
+bool Simulator::acquireUnit(Instruction *I){
+
+    int type = (int)(*I).type;
+    if(unitBusy[type] == unitTable[type].count){
+        stats.stalls[unitTable[type].busyCause]++;
+        if(profile)
+            profile->stall((*I).program_counter, unitTable[type].busyCause);
+        return 0;
     }
+
+    unitBusy[type]++;
+    (*I).latencyLeft = unitTable[type].latency;
+    return 1;
+}
+
+/**
+ * Spend a cycle of I's latency in its unit
+ * A pipelined unit is handed to the next instruction after the first cycle, an unpipelined one once I is done
+ * @param I instruction occupying a unit
+ * @return true once I's latency is over and it can leave the stage
+*/
+bool Simulator::unitCycle(Instruction *I){
+
+    int type = (int)(*I).type;
+    const UnitDescriptor &unit = unitTable[type];
+
+    (*I).latencyLeft--;
+    if(unit.pipelined && (*I).latencyLeft == unit.latency - 1)
+        unitBusy[type]--;
+    if((*I).latencyLeft > 0)
+        return 0;
+
+    if(!unit.pipelined)
+        unitBusy[type]--;
+    return 1;
 }
 
 /**
  * Parameterized Constructor
 */
 Simulator::Simulator(queue<Instruction> trace, unsigned short width){
-    this->trace = trace; 
+    ownedSource.reset(new QueueSource(trace));
+    init(*ownedSource, width);
+}
+
+/**
+ * Streaming Constructor
+ * Instructions are read from source as the pipeline needs them, so memory stays bounded by the window
+*/
+Simulator::Simulator(InstructionSource &source, unsigned short width){
+    init(source, width);
+}
+
+/**
+ * Shared constructor body
+*/
+void Simulator::init(InstructionSource &source, unsigned short width){
+    this->source = &source;
+    traceEmpty = !source.is_new_instruction_needed();
     this->width = width;
 
-    isIntAluIdle = isFloatAluIdle = isBeuIdle = isLoadIdle = isStoreIdle = 1;
+    setUnits(FunctionalUnitConfig());
     runningBranch = 0;
 
-    currentInstructions = vector<Instruction>();
+    currentInstructions = InstructionWindow(width * 5);
+
+    nextSequence = headSequence = 0;
+    producers.assign(width * 5, array<uint64_t, TRACE_MAX_DEPENDENCIES>());
+    newestProducer = unordered_map<uint64_t, uint64_t>();
 
     simulatedStats[0] = simulatedStats[1] = simulatedStats[2] = simulatedStats[3] = simulatedStats[4] = 0; 
+    clock = 1;
+    verbose = 1;
+    reportInterval = SIMULATOR_REPORT_INTERVAL;
+    setWarmup(0);
+
+    collectStats = 0;
+    stats.reset(width);
+
+    timeline = NULL;
+    telemetry = NULL;
+    profile = NULL;
+
+    checkpointInterval = 0;
+    restored = 0;
+}
+
+/**
+ * Build the unit descriptor table from config, all units start idle
+ * ALUs and the BEU are held in EX, the load and store ports in MM
+*/
+void Simulator::setUnits(const FunctionalUnitConfig &config){
+
+    static const StallCause busyCauses[5] = {STALL_INT_ALU_BUSY, STALL_FLOAT_ALU_BUSY, STALL_BEU_BUSY,
+        STALL_LOAD_PORT_BUSY, STALL_STORE_PORT_BUSY};
+
+    // A unit count of 0 would stall acquireUnit forever
+    units = config.clamped();
+    for(int i = 0; i < 5; i++){
+        unitTable[i].stage = i == (int)InstructionType::LOAD || i == (int)InstructionType::STORE ?
+            InstructionStage::MM : InstructionStage::EX;
+        unitTable[i].count = units.units[i].count;
+        unitTable[i].latency = units.units[i].latency;
+        unitTable[i].pipelined = units.units[i].pipelined;
+        unitTable[i].busyCause = busyCauses[i];
+        unitBusy[i] = 0;
+    }
+}
+
+void Simulator::setVerbose(bool verbose){
+    this->verbose = verbose;
+}
+
+void Simulator::setReportInterval(long long cycles){
+    reportInterval = cycles;
+}
+
+void Simulator::setWarmup(long long instructions){
+    warmupInstructions = instructions;
+    warmupCycle = -1;
+    warmupRetired = 0;
+    warmedUp = instructions <= 0;
+}
+
+void Simulator::setCollectStats(bool collectStats){
+    this->collectStats = collectStats;
+}
+
+PipelineStats Simulator::getStats(){
+
+    PipelineStats result = stats;
+    result.cycles = clock;
+    for(int i = 0; i < 5; i++)
+        result.retired[i] = simulatedStats[i];
+
+    return result;
+}
+
+/**
+ * Add the state at the end of the current cycle to the histograms
+ * @param retired instructions retired this cycle
+*/
+void Simulator::recordCycleStats(int retired){
+
+    stats.occupancy[currentInstructions.size()]++;
+    stats.retiredPerCycle[retired]++;
+
+    for(int i = 0; i < currentInstructions.size(); i++)
+        stats.stageOccupancy[(int)currentInstructions.at(i).currentStage]++;
+}
+
+void Simulator::setProfile(HotspotProfile *profile){
+    this->profile = profile;
+}
+
+void Simulator::setTimeline(PipelineTimeline *timeline){
+    this->timeline = timeline;
+    stageCycles.assign(timeline ? width * 5 : 0, array<long long, 7>());
+}
+
+/**
+ * Stamp the stage I just entered with the current cycle
+ * newInstr() goes through IF into DE in the same cycle, so both are stamped then
+*/
+void Simulator::recordStage(const Instruction &I, uint64_t sequence){
+
+    array<long long, 7> &cycles = stageCycles[sequence % stageCycles.size()];
+    int stage = (int)I.currentStage;
+
+    if(stage == (int)InstructionStage::DE)
+        cycles[(int)InstructionStage::IF] = clock;
+    cycles[stage] = clock;
+}
+
+void Simulator::setTelemetry(TelemetryRecorder *telemetry){
+    this->telemetry = telemetry;
+}
+
+/**
+ * Take the current counters as the start of an interval
+ * Intervals end on multiples of the telemetry interval, so a restored run keeps the same boundaries
+ * @param firstCycle first cycle of the interval
+*/
+void Simulator::startInterval(long long firstCycle){
+
+    long long interval = telemetry->getInterval();
+
+    intervalStart.startCycle = firstCycle;
+    intervalStart.cycles = 0;
+    for(int i = 0; i < 5; i++)
+        intervalStart.retired[i] = simulatedStats[i];
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        intervalStart.stalls[i] = stats.stalls[i];
+    intervalEnd = (firstCycle + interval - 1) / interval * interval;
+}
+
+/**
+ * Hand what changed since startInterval() to the recorder and start the next interval
+ * @param lastCycle last cycle of the interval
+*/
+void Simulator::endInterval(long long lastCycle){
+
+    IntervalSample sample;
+    sample.startCycle = intervalStart.startCycle;
+    sample.cycles = lastCycle - intervalStart.startCycle + 1;
+    sample.dropped = 0;
+    for(int i = 0; i < 5; i++)
+        sample.retired[i] = simulatedStats[i] - intervalStart.retired[i];
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        sample.stalls[i] = stats.stalls[i] - intervalStart.stalls[i];
+
+    if(sample.cycles > 0)
+        telemetry->record(sample);
+
+    startInterval(lastCycle + 1);
+}
+
+void requestCheckpoint(){
+    checkpointRequested = 1;
+}
+
+void Simulator::setCheckpoint(const string &path, long long everyCycles, const CheckpointTrace &trace){
+    checkpointPath = path;
+    checkpointInterval = everyCycles;
+    checkpointTrace = trace;
+}
+
+/**
+ * Save to checkpointPath if the interval is up or a checkpoint was requested, called between cycles
+*/
+void Simulator::checkpointIfDue(){
+
+    if(!(checkpointInterval > 0 && clock % checkpointInterval == 0) && !checkpointRequested)
+        return;
+
+    checkpointRequested = 0;
+    if(!saveCheckpoint(checkpointPath))
+        cerr << "Error: cannot write checkpoint " << checkpointPath << endl;
+    else if(verbose)
+        cout << "Checkpoint saved at cycle " << clock << "\n\n";
+}
+
+/**
+ * Write the header and everything simulate() needs to continue exactly where it is
+ * Only producer index entries still in flight are kept, older ones can no longer be matched
+ * @param path checkpoint file, replaced once the new one is complete
+ * @returns false if the file can't be written
+*/
+bool Simulator::saveCheckpoint(const string &path){
+
+    CheckpointWriter out;
+    if(!out.open(path))
+        return false;
+
+    out.put(width);
+    out.putString(checkpointTrace.path);
+    out.put(checkpointTrace.startInst);
+    out.put(checkpointTrace.instCount);
+    out.put(nextSequence);
+
+    out.put(clock);
+    for(int i = 0; i < 5; i++){
+        out.put(units.units[i].count);
+        out.put(units.units[i].latency);
+        out.put(units.units[i].pipelined);
+        out.put(unitBusy[i]);
+    }
+    out.put(runningBranch);
+    out.put(traceEmpty);
+    out.put(headSequence);
+    for(int i = 0; i < 5; i++)
+        out.put(simulatedStats[i]);
+
+    out.put(warmupInstructions);
+    out.put(warmupCycle);
+    out.put(warmupRetired);
+    out.put(warmedUp);
+
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        out.put(stats.stalls[i]);
+    for(int i = 0; i < 7; i++)
+        out.put(stats.stageOccupancy[i]);
+    for(int i = 0; i < (int)stats.occupancy.size(); i++)
+        out.put(stats.occupancy[i]);
+    for(int i = 0; i < (int)stats.retiredPerCycle.size(); i++)
+        out.put(stats.retiredPerCycle[i]);
+
+    out.put(currentInstructions.size());
+    for(int i = 0; i < currentInstructions.size(); i++){
+        Instruction &I = currentInstructions.at(i);
+        uint64_t sequence = headSequence + i;
+        out.put(I.program_counter);
+        out.put((uint64_t)I.type);
+        out.put((uint64_t)I.currentStage);
+        out.put(sequence);
+        out.put(I.latencyLeft);
+        out.put(I.dependencyCount);
+        for(int d = 0; d < I.dependencyCount; d++){
+            out.put(I.dependencies[d]);
+            out.put(producers[sequence % producers.size()][d]);
+        }
+    }
+
+    uint64_t inFlight = 0;
+    for(unordered_map<uint64_t, uint64_t>::iterator it = newestProducer.begin(); it != newestProducer.end(); it++)
+        inFlight += it->second >= headSequence;
+    out.put(inFlight);
+    for(unordered_map<uint64_t, uint64_t>::iterator it = newestProducer.begin(); it != newestProducer.end(); it++){
+        if(it->second >= headSequence){
+            out.put(it->first);
+            out.put(it->second);
+        }
+    }
+
+    return out.close();
+}
+
+bool Simulator::restoreCheckpoint(const string &path){
+
+    CheckpointReader in;
+    if(!in.open(path) || in.get() != width)
+        return false;
+
+    checkpointTrace.path = in.getString();
+    checkpointTrace.startInst = (long long)in.get();
+    checkpointTrace.instCount = (long long)in.get();
+    nextSequence = in.get();
+
+    clock = (long long)in.get();
+    FunctionalUnitConfig config;
+    int busy[5];
+    for(int i = 0; i < 5; i++){
+        uint64_t count = in.get(), latency = in.get();
+        config.units[i].pipelined = in.get();
+        uint64_t inUse = in.get();
+        if(count < 1 || count > INT_MAX || latency < 1 || latency > INT_MAX || inUse > count)
+            return false;
+        config.units[i].count = (int)count;
+        config.units[i].latency = (int)latency;
+        busy[i] = (int)inUse;
+    }
+    setUnits(config);
+    for(int i = 0; i < 5; i++)
+        unitBusy[i] = busy[i];
+    runningBranch = in.get();
+    traceEmpty = in.get();
+    headSequence = in.get();
+    for(int i = 0; i < 5; i++)
+        simulatedStats[i] = (long long)in.get();
+
+    warmupInstructions = (long long)in.get();
+    warmupCycle = (long long)in.get();
+    warmupRetired = (long long)in.get();
+    warmedUp = in.get();
+
+    for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+        stats.stalls[i] = (long long)in.get();
+    for(int i = 0; i < 7; i++)
+        stats.stageOccupancy[i] = (long long)in.get();
+    for(int i = 0; i < (int)stats.occupancy.size(); i++)
+        stats.occupancy[i] = (long long)in.get();
+    for(int i = 0; i < (int)stats.retiredPerCycle.size(); i++)
+        stats.retiredPerCycle[i] = (long long)in.get();
+
+    uint64_t count = in.get();
+    if(!in.ok() || count > (uint64_t)width * 5 || headSequence + count != nextSequence)
+        return false;
+
+    currentInstructions = InstructionWindow(width * 5);
+    for(uint64_t i = 0; i < count && in.ok(); i++){
+        Instruction I;
+        I.program_counter = in.get();
+        uint64_t type = in.get(), stage = in.get();
+        uint64_t sequence = in.get();
+        I.latencyLeft = (int)in.get();
+
+        // type indexes unitTable, stage the stage switch
+        uint64_t dependencies = in.get();
+        if(sequence != headSequence + i || dependencies > TRACE_MAX_DEPENDENCIES || type > (uint64_t)InstructionType::STORE ||
+            stage > (uint64_t)InstructionStage::RT)
+            return false;
+        I.type = static_cast<InstructionType>(type);
+        I.currentStage = static_cast<InstructionStage>(stage);
+        for(uint64_t d = 0; d < dependencies && in.ok(); d++){
+            I.addDependency(in.get());
+
+            // A producer is older than its consumer, or NO_PRODUCER
+            uint64_t producer = in.get();
+            if(producer != NO_PRODUCER && producer >= sequence)
+                return false;
+            producers[sequence % producers.size()][d] = producer;
+        }
+        currentInstructions.push_back(I);
+    }
+
+    uint64_t inFlight = in.get();
+    newestProducer.clear();
+    for(uint64_t i = 0; i < inFlight && in.ok(); i++){
+        uint64_t pc = in.get(), sequence = in.get();
+        if(sequence < headSequence || sequence >= nextSequence)
+            return false;
+        newestProducer[pc] = sequence;
+    }
+
+    restored = in.ok();
+    return restored;
+}
+
+SimulationResults Simulator::getResults(){
+
+    SimulationResults results;
+    results.width = width;
+    results.cycles = clock;
+    for(int i = 0; i < 5; i++)
+        results.retired[i] = simulatedStats[i];
+
+    // Measured from the cycle the last warmup instruction retired to the last retirement
+    results.measuredCycles = clock - 1 - warmupCycle;
+    results.measuredRetired = results.totalRetired() - warmupRetired;
+
+    return results;
+}
+
+long long SimulationResults::totalRetired() const{
+    return retired[0] + retired[1] + retired[2] + retired[3] + retired[4];
+}
+
+double SimulationResults::ipc() const{
+    return cycles > 0 ? (double)totalRetired() / cycles : 0;
 }
 
 /**
@@ -49,57 +449,63 @@ Simulator::Simulator(queue<Instruction> trace, unsigned short width){
  * @param I instruction to check
  * @returns true if I is empty, false otherwise
 */
-bool Simulator::isInstructionEmpty(Instruction I){
-    return I.program_counter == "empty";
+bool Simulator::isInstructionEmpty(const Instruction &I){
+    return I.program_counter == EMPTY_PROGRAM_COUNTER;
 }
 
 /**
- * Rotate currentInstructions anti-clockwise, first element deleted; Every element moves left by 1
- * New instruction is now in the last position; If no more instructions, size reduces by 1
- * @returns deleted instruction, if currentInstructions is empty returns empty Instruction
+ * Retire the front of currentInstructions and refill the back from source
+ * While the window is still filling up nothing is removed, once source runs dry the window shrinks by 1
 */
-Instruction Simulator::updateCurrentInstructions(){
+void Simulator::updateCurrentInstructions(){
 
-    Instruction I;
-    int n = (int)currentInstructions.size();
-
-    if(n != 0)
-        I = currentInstructions.front();
+    int n = currentInstructions.size();
 
     // Always remove top except when populating for the first time, i.e.:
     //  If trace is not empty and max # instr in pipeline
     //  Or if trace empty (start depopulating)
-    if((n-- == width * 5 && !trace.empty()) || trace.empty()){
+    if(((n == width * 5 && !traceEmpty) || traceEmpty) && n != 0){
+        currentInstructions.pop_front();
+        headSequence++;
+    }
 
-        // n already reduced by 1 so iteration is within bounds
-        for(int i = 0; i < n; i++)
-            currentInstructions.at(i) = currentInstructions.at(i + 1);
+    if(!traceEmpty)
+        pullInstruction();
+}
 
-        currentInstructions.erase(currentInstructions.begin() + n);
-    }
+/**
+ * Move the next instruction from source to the back of currentInstructions
+ * Each dependency is resolved here to the newest older instruction with that program_counter,
+ * everything in flight is older than the new instruction at this point
+*/
+void Simulator::pullInstruction(){
+
+    Instruction &I = currentInstructions.push_back(source->get_next_instruction());
+    traceEmpty = !source->is_new_instruction_needed();
+
+    uint64_t sequence = nextSequence++;
+    array<uint64_t, TRACE_MAX_DEPENDENCIES> &resolved = producers[sequence % producers.size()];
 
-    if(!trace.empty()){
-        currentInstructions.push_back(trace.front());
-        trace.pop();
+    for(int i = 0; i < I.dependencyCount; i++){
+        unordered_map<uint64_t, uint64_t>::iterator producer = newestProducer.find(I.dependencies[i]);
+        resolved[i] = producer != newestProducer.end() && producer->second >= headSequence ? producer->second : NO_PRODUCER;
     }
 
-    return I;
+    newestProducer[I.program_counter] = sequence;
 }
 
 /**
- * Finds instruction corresponding to pc among currentInstructions
- * @param pc program_counter to find
- * @returns index of Instruction that has "program_counter" == pc in currentInstructions
+ * Finds a producer recorded by pullInstruction() among currentInstructions
+ * @param producer sequence number of the producer
+ * @returns index of the producer in currentInstructions, -1 if it is no longer in flight
 */
-int Simulator::find(string pc, int start){
-
-    for(int i = start - 1; i >= 0; i--){
-        if(pc == currentInstructions.at(i).program_counter)
-            return i;
-    }
+int Simulator::find(uint64_t producer){
 
     // dependency either already completed or was from older trace
-    return -1;
+    if(producer == NO_PRODUCER || producer < headSequence)
+        return -1;
+
+    return (int)(producer - headSequence);
 }
 
 /**
@@ -107,7 +513,7 @@ int Simulator::find(string pc, int start){
  * @param I dependence
  * @return true if dependence satisfied (I has completed EX phase), false otherwise
 */
-bool Simulator::branchDepSatisfied(Instruction I){
+bool Simulator::branchDepSatisfied(const Instruction &I){
 
     // Current stage must not be New - EX, anything after/else is fine
     return I.currentStage != static_cast<InstructionStage>(0) && 
@@ -121,7 +527,7 @@ bool Simulator::branchDepSatisfied(Instruction I){
  * @param I dependence
  * @return true if dependence satisfied (I has completed EX phase), false otherwise
 */
-bool Simulator::aluDepSatisfied(Instruction I){
+bool Simulator::aluDepSatisfied(const Instruction &I){
 
     // Current stage must not be New - EX, anything after/else is fine
     return branchDepSatisfied(I);
@@ -132,7 +538,7 @@ bool Simulator::aluDepSatisfied(Instruction I){
  * @param I dependence
  * @return true if dependence satisfied (I has completed MEM phase), false otherwise
 */
-bool Simulator::loadStoreDepSatisfied(Instruction I){
+bool Simulator::loadStoreDepSatisfied(const Instruction &I){
 
     // Current stage must not be New - MEM, anything after/else is fine
     return branchDepSatisfied(I) && I.type != static_cast<InstructionType>(4);
@@ -141,8 +547,12 @@ bool Simulator::loadStoreDepSatisfied(Instruction I){
 bool Simulator::newInstr(Instruction *I){
 
     // If a branch is being run (not completed exec phase), I must wait to be fetched
-    if(runningBranch)
+    if(runningBranch){
+        stats.stalls[STALL_FETCH_BRANCH]++;
+        if(profile)
+            profile->stall((*I).program_counter, STALL_FETCH_BRANCH);
         return 1;
+    }
 
     // If I is a branch Instruction
     if((*I).type == static_cast<InstructionType>(2))
@@ -172,17 +582,19 @@ bool Simulator::fetch(Instruction *I){
 /**
  * Carry out decode (DE) stage of CPU pipeline
  * @param I instruction to be fetched
+ * @param sequence sequence number of I
  * @return true if stalled, else false
 */
-bool Simulator::decode(Instruction *I, int ind){
+bool Simulator::decode(Instruction *I, uint64_t sequence){
 
     // If data dependency exists stall (stay in decode, don't proceed to execute)
     //  dependency on ALU satisfied after EX phase is completed
     //  dependency on load/store after MEM phase is completed
     // Note: ALU dependency here is a data dependency, once instruction using ALU finishes EX the result can be used
-    for (int i = 0; i < (int)(*I).dependencies.size(); i++){
+    const array<uint64_t, TRACE_MAX_DEPENDENCIES> &resolved = producers[sequence % producers.size()];
+    for (int i = 0; i < (*I).dependencyCount; i++){
 
-        int index = find((*I).dependencies.at(i), ind);
+        int index = find(resolved[i]);
 
         if(index == -1)
             continue;
@@ -190,48 +602,29 @@ bool Simulator::decode(Instruction *I, int ind){
         Instruction dependency;
 
         // If dependency instruction is int/ float OP and dependency not satisfied then return
-        if((dependency.type == static_cast<InstructionType>(0) || dependency.type == static_cast<InstructionType>(1)) && !aluDepSatisfied(dependency))
-            return 1;
-
         // If dependency instruction is load/ store OP and dependency not satisfied then return
-        if((dependency.type == static_cast<InstructionType>(3) || dependency.type == static_cast<InstructionType>(4)) && !loadStoreDepSatisfied(dependency))
+        if(((dependency.type == static_cast<InstructionType>(0) || dependency.type == static_cast<InstructionType>(1)) && !aluDepSatisfied(dependency)) ||
+            ((dependency.type == static_cast<InstructionType>(3) || dependency.type == static_cast<InstructionType>(4)) && !loadStoreDepSatisfied(dependency))){
+
+            // Attributed to the type of the producer in flight
+            const Instruction &producer = currentInstructions.at(index);
+            StallCause cause = producer.type == InstructionType::LOAD || producer.type == InstructionType::STORE ?
+                STALL_RAW_LOAD_STORE : STALL_RAW_ALU;
+            stats.stalls[cause]++;
+            if(profile){
+                profile->stall((*I).program_counter, cause);
+                profile->blame(producer.program_counter);
+            }
             return 1;
+        }
     }
 
-    switch((*I).type){
-
-        // If int/ float ALU needed but busy, stall till the dependency completes EX phase
-
-        // If int OP and ALU busy, return
-        case static_cast<InstructionType>(0):
-        if(!isIntAluIdle)
-            return 1;
-        // Else, occupy the int ALU
-        isIntAluIdle = 0;
-        break;
-
-        // If float OP and ALU busy, return
-        case static_cast<InstructionType>(1):
-        if(!isFloatAluIdle)
-            return 1;
-        // Else, occupy the float ALU
-        isFloatAluIdle = 0;
-        break;
-
-        // If BEU needed but busy, stall then stall till the dependency completes EX phase
+    // If the int/ float ALU or BEU I needs are all busy, stall till one completes EX phase
+    if(unitTable[(int)(*I).type].stage == InstructionStage::EX && !acquireUnit(I))
+        return 1;
 
-        // If branch and BEU busy, return
-        case static_cast<InstructionType>(2):
-        if(!isBeuIdle)
-            return 1;
-        // Else, occupy the BEU
-        isBeuIdle = 0;
+    if((*I).type == InstructionType::BRANCH)
         runningBranch = 1;
-        break;
-
-        default:
-            break;
-    }
 
     // Either no dependency exists or all dependencies satisfied, can move to next phase
     // Current Stage of I is now EX
@@ -246,35 +639,19 @@ bool Simulator::decode(Instruction *I, int ind){
 */
 bool Simulator::execute(Instruction *I){
 
-    // Note: ALU dependency here is structural, cannot use ALUs if they are already in use
-    switch((*I).type){
-
-        // If inst is LOAD and another LOAD is in MEM phase, stall
-        // If inst is STORE and another STORE is in MEM phase, stall
-        // Freed once MEM phase is complete not here
-
-        // If load and there is a load in MEM phase, return
-        case static_cast<InstructionType>(3):
-        if(!isLoadIdle)
-            return 1;
-        // Else, start load
-        isLoadIdle = 0;
-        break;
-
-        // If store and there is a store in MEM phase, return
-        case static_cast<InstructionType>(4):
-        if(!isStoreIdle)
-            return 1;
-        // Else, start store
-        isStoreIdle = 0;
-        break;
-
-        default:
-            break;
+    // ALU and BEU instructions stay in EX for their unit's latency; younger instructions are not held up
+    // A branch is resolved once it leaves EX
+    if(unitTable[(int)(*I).type].stage == InstructionStage::EX){
+        if(!unitCycle(I))
+            return 0;
+        if((*I).type == InstructionType::BRANCH)
+            runningBranch = 0;
     }
 
-    if((int)(*I).type == 0 || (int)(*I).type == 1 || (int)(*I).type == 2)
-        freeResource(*I);
+    // If inst is LOAD/ STORE and all load/ store ports are in MEM phase, stall
+    // Freed once MEM phase is complete not here
+    else if(!acquireUnit(I))
+        return 1;
 
     // Either no dependency exists or all dependencies satisfied, can move to next phase
     // Current Stage of I is now MEM
@@ -289,9 +666,9 @@ bool Simulator::execute(Instruction *I){
 */
 bool Simulator::memoryAccess(Instruction *I){
 
-    // Free up the resource(s) that I was using
-    if((int)(*I).type == 3 || (int)(*I).type == 4)
-        freeResource(*I);
+    // Loads and stores stay in MEM for their port's latency, then free it
+    if(unitTable[(int)(*I).type].stage == InstructionStage::MM && !unitCycle(I))
+        return 0;
 
     // Current Stage of I is now WB
     (*I).currentStage = static_cast<InstructionStage>(5);
@@ -314,7 +691,7 @@ bool Simulator::writeBack(Instruction *I){
  * Increment corresponding Instruction type processed count in simulatedStats
  * @param I Instruction whose type is to be incremented
 */
-void Simulator::updateSimulatedStats(Instruction I){
+void Simulator::updateSimulatedStats(const Instruction &I){
 
     switch(I.type){
         
@@ -336,7 +713,16 @@ void Simulator::updateSimulatedStats(Instruction I){
     }
 }
 
-void Simulator::printReport(int clock){
+void Simulator::printReport(long long clock){
+    printSimulationReport(clock, simulatedStats);
+}
+
+/**
+ * Print cycles elapsed and the breakdown of retired instructions by type
+ * @param clock clock cycles elapsed
+ * @param simulatedStats retired instruction count per InstructionType
+*/
+void printSimulationReport(long long clock, const long long simulatedStats[5]){
 
     double tot = (simulatedStats[0] + simulatedStats[1] + simulatedStats[2] + simulatedStats[3] + simulatedStats[4])
         / 100.0;
@@ -372,14 +758,20 @@ void Simulator::printReport(int clock){
 */
 void Simulator::simulate(){
 
-    cout << "Starting Simulation...\n\n";
+    if(verbose)
+        cout << "Starting Simulation...\n\n";
 
-    int clock = 1;
     bool stalled = 0;
 
-    // Retrieve first instruction(s)
-    for(int ii = 0; ii < width; ii++)
-        updateCurrentInstructions();
+    // Retrieve first instruction(s), a restored checkpoint already has them
+    if(!restored){
+        clock = 1;
+        for(int ii = 0; ii < width; ii++)
+            updateCurrentInstructions();
+    }
+
+    if(telemetry)
+        startInterval(clock);
 
     Instruction *I;
 
@@ -393,6 +785,7 @@ void Simulator::simulate(){
         for (i = 0; i < (int)currentInstructions.size(); i++){
             
             I = &(currentInstructions.at(i));
+            InstructionStage previousStage = (*I).currentStage;
 
             switch((*I).currentStage){
 
@@ -408,7 +801,7 @@ void Simulator::simulate(){
 
                 // Decode    
                 case static_cast<InstructionStage>(2):
-                    stalled = decode(I, i);
+                    stalled = decode(I, headSequence + i);
                     break;
 
                 // Execute
@@ -432,26 +825,56 @@ void Simulator::simulate(){
 
             if(stalled)
                 break;
+
+            if(timeline && (*I).currentStage != previousStage)
+                recordStage(*I, headSequence + i);
                 
         }
 
         // only instructions from the first w will be retired (0 to w-1)
-        for(int ii = 0; ii < min(width, (unsigned short)currentInstructions.size()); ii++){
+        int retiredThisCycle = 0;
+        for(int ii = 0; ii < min((int)width, currentInstructions.size()); ii++){
 
-            bool retiredFlag = currentInstructions.at(0).currentStage == static_cast<InstructionStage>(6);
+            bool retiredFlag = currentInstructions.front().currentStage == static_cast<InstructionStage>(6);
 
             // update when either not full size or instr retired
-            // .at(0) since after updating the removed instruction is gone and next to be checked is at the front
-            if(retiredFlag || (currentInstructions.size() < width * 5 && !trace.empty())){
+            // .front() since after updating the removed instruction is gone and next to be checked is at the front
+            if(retiredFlag || (currentInstructions.size() < width * 5 && !traceEmpty)){
+
+                // Count before the front's slot is reused by the refill
+                if(retiredFlag){
+                    updateSimulatedStats(currentInstructions.front());
+                    retiredThisCycle++;
+
+                    if(profile)
+                        profile->retire(currentInstructions.front().program_counter);
 
-                Instruction retired = updateCurrentInstructions();
+                    if(timeline){
+                        timeline->write(currentInstructions.front(), headSequence,
+                            stageCycles[headSequence % stageCycles.size()].data());
+                    }
+                }
 
-                if(retiredFlag)
-                    updateSimulatedStats(retired);
+                updateCurrentInstructions();
             }
         }
 
-        if(clock % 200000 == 0)
+        if(collectStats)
+            recordCycleStats(retiredThisCycle);
+
+        if(!warmedUp){
+            long long retired = simulatedStats[0] + simulatedStats[1] + simulatedStats[2] + simulatedStats[3] + simulatedStats[4];
+            if(retired >= warmupInstructions){
+                warmupCycle = clock;
+                warmupRetired = retired;
+                warmedUp = 1;
+            }
+        }
+
+        if(telemetry && clock >= intervalEnd)
+            endInterval(clock);
+
+        if(verbose && reportInterval > 0 && clock % reportInterval == 0)
             printReport(clock);
 
         // Reset stalled
@@ -464,8 +887,18 @@ void Simulator::simulate(){
         // If currentInstructions is empty (no more instructions were retrieved from trace), end of sim
         if(currentInstructions.empty())
             break;
+
+        if(!checkpointPath.empty())
+            checkpointIfDue();
     }
 
+    // The loop has moved clock past the last cycle
+    if(telemetry)
+        endInterval(clock - 1);
+
+    if(!verbose)
+        return;
+
     cout << "Simulation Results" << endl;
     printReport(clock);
     cout << "Done exiting...\n";
@@ -3,52 +3,200 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <array>
 
 #include "instruction.h"
 #include "ReadInput.h"
+#include "InstructionSource.h"
+#include "InstructionWindow.h"
+#include "PipelineStats.h"
+#include "PipelineTimeline.h"
+#include "HotspotProfile.h"
+#include "Checkpoint.h"
+#include "FunctionalUnits.h"
+#include "Telemetry.h"
 
 #ifndef SIMULATOR_H_
 #define SIMULATOR_H_
 
+// Default cycles between progress reports
+#define SIMULATOR_REPORT_INTERVAL 200000
+
+// Totals of a finished simulation
+struct SimulationResults {
+    unsigned short width;
+    long long cycles;
+    long long retired[5];     // indexed by InstructionType
+
+    // Cycles and instructions after the warmup prefix, same as the totals without warmup
+    long long measuredCycles;
+    long long measuredRetired;
+
+    long long totalRetired() const;
+    double ipc() const;
+};
+
+// Prints the cycle count and retired instruction mix in the simulator's report format
+void printSimulationReport(long long clock, const long long simulatedStats[5]);
+
+// Asks running simulations with a checkpoint path to save at the end of the current cycle, safe in a signal handler
+void requestCheckpoint();
+
 class Simulator {
   private:
-    bool isIntAluIdle, isFloatAluIdle, isBeuIdle,
-      isLoadIdle, isStoreIdle, runningBranch;
+    // Functional units per InstructionType: where they are held, how many, how long, and how many are busy
+    struct UnitDescriptor {
+        InstructionStage stage;
+        int count;
+        int latency;
+        bool pipelined;
+        StallCause busyCause;
+    };
+    FunctionalUnitConfig units;
+    UnitDescriptor unitTable[5];
+    int unitBusy[5];
+    bool runningBranch;
     unsigned short width;
-    vector<Instruction> currentInstructions;
-    queue<Instruction> trace;
-    int simulatedStats[5];
+    InstructionWindow currentInstructions;
+
+    // Instructions are pulled from source only when the pipeline window has room
+    InstructionSource *source;
+    unique_ptr<InstructionSource> ownedSource;
+    bool traceEmpty;
+
+    // Sequence numbers of the next instruction to enter and of currentInstructions.front()
+    // currentInstructions.at(i) has sequence number headSequence + i
+    uint64_t nextSequence, headSequence;
+
+    // producers[sequence % window size]: per dependency of an in-flight instruction, the sequence number of
+    // the newest older instruction with that program_counter (NO_PRODUCER if none was in flight)
+    vector<array<uint64_t, TRACE_MAX_DEPENDENCIES> > producers;
+
+    // program_counter -> sequence number of the newest instruction with it that entered the pipeline
+    // Entries older than headSequence have already left currentInstructions
+    unordered_map<uint64_t, uint64_t> newestProducer;
+    long long simulatedStats[5];
+    long long clock;
+
+    // Print progress every reportInterval cycles (0 for never) and the final report to stdout
+    bool verbose;
+    long long reportInterval;
+
+    // Warmup prefix: retirements up to warmupInstructions are not measured
+    long long warmupInstructions, warmupCycle, warmupRetired;
+    bool warmedUp;
+
+    // Stall counters are always kept, the per-cycle histograms only when collectStats is set
+    bool collectStats;
+    PipelineStats stats;
+    void recordCycleStats(int retired);
+
+    // Optional O3PipeView log, stageCycles[sequence % window size] holds the cycle each in-flight
+    // instruction entered every stage
+    PipelineTimeline *timeline;
+    vector<array<long long, 7> > stageCycles;
+    void recordStage(const Instruction&, uint64_t sequence);
+
+    // Optional per program counter profile of retirements and stall cycles
+    HotspotProfile *profile;
+
+    // Optional interval time series: counters at the start of the current interval and the cycle it ends
+    TelemetryRecorder *telemetry;
+    IntervalSample intervalStart;
+    long long intervalEnd;
+    void startInterval(long long firstCycle);
+    void endInterval(long long lastCycle);
+
+    // Checkpoints are saved between cycles to checkpointPath, every checkpointInterval cycles (0 for never)
+    // and whenever requestCheckpoint() was called; restored says simulate() resumes instead of starting over
+    CheckpointTrace checkpointTrace;
+    string checkpointPath;
+    long long checkpointInterval;
+    bool restored;
+    void checkpointIfDue();
 
     // Helper functions
-    void freeResource(Instruction);
-    int find(string, int);
-    bool isInstructionEmpty(Instruction);
-    Instruction updateCurrentInstructions();
+    void init(InstructionSource&, unsigned short);
+    bool acquireUnit(Instruction*);
+    bool unitCycle(Instruction*);
+    int find(uint64_t);
+    bool isInstructionEmpty(const Instruction&);
+    void updateCurrentInstructions();
+    void pullInstruction();
 
     // Functions to check if dependencies are satisfied
-    bool branchDepSatisfied(Instruction);
-    bool aluDepSatisfied(Instruction);
-    bool loadStoreDepSatisfied(Instruction);
+    bool branchDepSatisfied(const Instruction&);
+    bool aluDepSatisfied(const Instruction&);
+    bool loadStoreDepSatisfied(const Instruction&);
 
     // Functions for each stage in the pipeline
     bool newInstr(Instruction*);
     bool fetch(Instruction*);
-    bool decode(Instruction*, int);
+    bool decode(Instruction*, uint64_t sequence);
     bool execute(Instruction*);
     bool memoryAccess(Instruction*);
     bool writeBack(Instruction*);
 
     // Simulated Statistics Functions
-    void updateSimulatedStats(Instruction);
-    void printReport(int);
+    void updateSimulatedStats(const Instruction&);
+    void printReport(long long);
     
   public:
     // Parameterized Constructor
     Simulator(queue<Instruction>, unsigned short);
 
+    // Streaming Constructor, source must outlive the Simulator
+    Simulator(InstructionSource&, unsigned short);
+
     // The function that carries out the simulation
     void simulate();
 
+    // Functional unit counts, latencies and pipelining, before simulate() (one 1-cycle unit of each kind by default);
+    // counts and latencies below 1 are raised to 1
+    void setUnits(const FunctionalUnitConfig&);
+
+    // Turns the stdout reports on or off (on by default)
+    void setVerbose(bool);
+
+    // Cycles between progress reports, 0 for none (default 200000)
+    void setReportInterval(long long cycles);
+
+    // Treat the first instructions as warmup for SimulationResults::measuredCycles/measuredRetired
+    void setWarmup(long long instructions);
+
+    // Cycles and retired instruction mix, valid after simulate()
+    SimulationResults getResults();
+
+    // Collect occupancy and retirement histograms every cycle (off by default)
+    void setCollectStats(bool);
+
+    // Stall attribution and histograms, valid after simulate()
+    PipelineStats getStats();
+
+    // Send per-interval deltas to telemetry (NULL to stop), telemetry must outlive simulate()
+    void setTelemetry(TelemetryRecorder*);
+
+    // Count retirements and stall cycles per program counter in profile (NULL to stop), profile must outlive simulate()
+    void setProfile(HotspotProfile*);
+
+    // Log every retired instruction's stage cycles to timeline (NULL to stop), timeline must outlive simulate()
+    void setTimeline(PipelineTimeline*);
+
+    // Save to path every everyCycles cycles (0 for only on request) while simulating trace
+    void setCheckpoint(const string &path, long long everyCycles, const CheckpointTrace &trace);
+
+    // Writes the complete simulator state, returns false on failure
+    bool saveCheckpoint(const string &path);
+
+    /**
+     * Loads the state saved by saveCheckpoint(), simulate() then resumes from there
+     * The source must be positioned after the instructions the checkpointed run had read (see readCheckpointHeader())
+     * @returns false if path is not a checkpoint of this width
+    */
+    bool restoreCheckpoint(const string &path);
+
 };
 
 #endif
@@ -0,0 +1,64 @@
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+// Keeps the producer's and consumer's indices on separate cache lines
+#define SPSC_CACHE_LINE 64
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread
+ * push() and pop() never block, they return false when the ring is full or empty.
+ * Everything the producer wrote before a push() is visible to the consumer after the matching pop().
+*/
+template<class T>
+class SpscRing {
+  private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // Next slot to pop, written only by the consumer
+    char padHead[SPSC_CACHE_LINE];
+    std::atomic<size_t> head;
+
+    // Next slot to push, written only by the producer
+    char padTail[SPSC_CACHE_LINE];
+    std::atomic<size_t> tail;
+    char padEnd[SPSC_CACHE_LINE];
+
+  public:
+    // Constructor, capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity){
+        size_t size = 1;
+        while(size < capacity)
+            size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    // Producer side, returns false if the ring is full
+    bool push(const T &value){
+        size_t at = tail.load(std::memory_order_relaxed);
+        if(at - head.load(std::memory_order_acquire) == slots.size())
+            return false;
+        slots[at & mask] = value;
+        tail.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false if the ring is empty
+    bool pop(T &value){
+        size_t at = head.load(std::memory_order_relaxed);
+        if(at == tail.load(std::memory_order_acquire))
+            return false;
+        value = slots[at & mask];
+        head.store(at + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif
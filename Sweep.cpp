@@ -0,0 +1,80 @@
+#include "Sweep.h"
+#include "EventSimulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+bool parseWidthList(const string &list, vector<unsigned short> &widths){
+
+    widths.clear();
+    stringstream ss(list);
+    string item;
+
+    while(getline(ss, item, ',')){
+        size_t dash = item.find('-');
+        int first = atoi(item.substr(0, dash).c_str());
+        int last = dash == string::npos ? first : atoi(item.substr(dash + 1).c_str());
+
+        if(first <= 0 || last < first || last > 65535 / 5)
+            return false;
+
+        for(int w = first; w <= last; w++)
+            widths.push_back(w);
+    }
+
+    return !widths.empty();
+}
+
+/**
+ * Simulate source to the end without printing
+*/
+template<class Engine>
+static SimulationResults runQuiet(InstructionSource &source, unsigned short width){
+    Engine simulator(source, width);
+    simulator.setVerbose(0);
+    simulator.simulate();
+    return simulator.getResults();
+}
+
+/**
+ * Run one Simulator per width over the shared trace
+ * @param trace decoded window, read concurrently by every thread
+ * @param widths pipeline widths to simulate
+ * @param eventEngine use EventSimulator instead of Simulator
+ * @returns results of each width, same order as widths
+*/
+vector<SimulationResults> runWidthSweep(const vector<TraceRecord> &trace, const vector<unsigned short> &widths,
+    bool eventEngine){
+
+    vector<SimulationResults> results(widths.size());
+    vector<thread> threads;
+
+    for(int i = 0; i < (int)widths.size(); i++){
+        threads.push_back(thread([&trace, &widths, &results, i, eventEngine](){
+            RecordSource source(trace.data(), trace.size());
+            results[i] = eventEngine ? runQuiet<EventSimulator>(source, widths[i]) : runQuiet<Simulator>(source, widths[i]);
+        }));
+    }
+
+    for(int i = 0; i < (int)threads.size(); i++)
+        threads[i].join();
+
+    return results;
+}
+
+void printSweepTable(vector<SimulationResults> &results){
+
+    printf("Width\tCycles\t\tIPC\tInteger\t\tFloat\t\tBranch\t\tLoad\t\tStore\n");
+
+    for(int i = 0; i < (int)results.size(); i++){
+        SimulationResults &r = results[i];
+        double tot = r.totalRetired() / 100.0;
+        if(tot == 0)
+            tot = 1;
+
+        printf("%d\t%lld\t\t%.4f\t%.4f%%\t%.4f%%\t%.4f%%\t%.4f%%\t%.4f%%\n", r.width, r.cycles, r.ipc(),
+            r.retired[0] / tot, r.retired[1] / tot, r.retired[2] / tot, r.retired[3] / tot, r.retired[4] / tot);
+    }
+}
@@ -0,0 +1,24 @@
+#include <string>
+#include <vector>
+
+#include "TraceParser.h"
+#include "Simulator.h"
+
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+// Parses a width list such as "1-8" or "1,2,4", returns false if it is malformed
+bool parseWidthList(const string &list, vector<unsigned short> &widths);
+
+/**
+ * Simulates the same trace once per width, each on its own thread
+ * All simulations read the shared, immutable records; results come back in the order of widths
+ * eventEngine selects EventSimulator instead of Simulator
+*/
+vector<SimulationResults> runWidthSweep(const vector<TraceRecord> &trace, const vector<unsigned short> &widths,
+    bool eventEngine = false);
+
+// Prints one row of cycles, IPC and retired instruction mix per width
+void printSweepTable(vector<SimulationResults> &results);
+
+#endif
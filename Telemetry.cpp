@@ -0,0 +1,160 @@
+#include <chrono>
+
+#include "Telemetry.h"
+
+static const char *typeNames[5] = {"integer", "floating_point", "branch", "load", "store"};
+
+TelemetryRecorder::TelemetryRecorder(){
+    file = NULL;
+    json = false;
+    interval = 0;
+    stopping = false;
+    written = dropped = 0;
+    failed = false;
+    gap.dropped = 0;
+}
+
+TelemetryRecorder::~TelemetryRecorder(){
+    close();
+}
+
+bool TelemetryRecorder::open(const std::string &path, long long intervalCycles){
+
+    close();
+
+    file = fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    interval = intervalCycles;
+    written = dropped = 0;
+    failed = false;
+    gap.dropped = 0;
+
+    // Shorter intervals arrive faster, so they get a longer ring
+    long long slots = TELEMETRY_RING_CYCLES / interval;
+    slots = slots < TELEMETRY_RING_MIN ? TELEMETRY_RING_MIN : slots > TELEMETRY_RING_MAX ? TELEMETRY_RING_MAX : slots;
+    ring.reset(new SpscRing<IntervalSample>(slots));
+
+    if(json)
+        failed = fprintf(file, "{\n  \"interval_cycles\": %lld,\n  \"intervals\": [", interval) < 0;
+    else {
+        failed = fprintf(file, "start_cycle,cycles,ipc,integer,floating_point,branch,load,store") < 0;
+        for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+            failed |= fprintf(file, ",stall_%s", stallCauseName(i)) < 0;
+        failed |= fprintf(file, "\n") < 0;
+    }
+
+    stopping = false;
+    writer = std::thread(&TelemetryRecorder::drain, this);
+    return !failed;
+}
+
+long long TelemetryRecorder::getInterval() const{
+    return interval;
+}
+
+/**
+ * A pending gap is queued ahead of sample so rows stay in cycle order
+*/
+bool TelemetryRecorder::record(const IntervalSample &sample){
+
+    if(gap.dropped > 0 && ring->push(gap))
+        gap.dropped = 0;
+    if(gap.dropped == 0 && ring->push(sample))
+        return true;
+
+    if(gap.dropped == 0)
+        gap.startCycle = sample.startCycle;
+    gap.cycles = sample.startCycle + sample.cycles - gap.startCycle;
+    gap.dropped++;
+    dropped++;
+    return false;
+}
+
+long long TelemetryRecorder::droppedSamples() const{
+    return dropped;
+}
+
+/**
+ * Writer thread: write samples as they arrive, sleep briefly when there are none
+ * so the simulation keeps the core; exits once stopping is set and the ring is empty
+*/
+void TelemetryRecorder::drain(){
+
+    IntervalSample sample;
+    while(true){
+        bool stop = stopping;
+        if(ring->pop(sample)){
+            writeSample(sample);
+            continue;
+        }
+        if(stop)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void TelemetryRecorder::writeSample(const IntervalSample &s){
+
+    // Gap rows keep the cycles of the dropped intervals and leave everything else empty
+    if(s.dropped > 0){
+        if(json)
+            failed |= fprintf(file, "%s\n    {\"start_cycle\": %lld, \"cycles\": %lld, \"dropped_intervals\": %lld}",
+                written ? "," : "", s.startCycle, s.cycles, s.dropped) < 0;
+        else {
+            failed |= fprintf(file, "%lld,%lld,", s.startCycle, s.cycles) < 0;
+            for(int i = 0; i < 5 + STALL_CAUSE_COUNT; i++)
+                failed |= fprintf(file, ",") < 0;
+            failed |= fprintf(file, "\n") < 0;
+        }
+        written++;
+        return;
+    }
+
+    long long retired = s.retired[0] + s.retired[1] + s.retired[2] + s.retired[3] + s.retired[4];
+    double ipc = s.cycles > 0 ? (double)retired / s.cycles : 0;
+
+    if(json){
+        failed |= fprintf(file, "%s\n    {\"start_cycle\": %lld, \"cycles\": %lld, \"ipc\": %.6f, \"retired\": {",
+            written ? "," : "", s.startCycle, s.cycles, ipc) < 0;
+        for(int i = 0; i < 5; i++)
+            failed |= fprintf(file, "%s\"%s\": %lld", i ? ", " : "", typeNames[i], s.retired[i]) < 0;
+        failed |= fprintf(file, "}, \"stall_cycles\": {") < 0;
+        for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+            failed |= fprintf(file, "%s\"%s\": %lld", i ? ", " : "", stallCauseName(i), s.stalls[i]) < 0;
+        failed |= fprintf(file, "}}") < 0;
+    }
+    else {
+        failed |= fprintf(file, "%lld,%lld,%.6f", s.startCycle, s.cycles, ipc) < 0;
+        for(int i = 0; i < 5; i++)
+            failed |= fprintf(file, ",%lld", s.retired[i]) < 0;
+        for(int i = 0; i < STALL_CAUSE_COUNT; i++)
+            failed |= fprintf(file, ",%lld", s.stalls[i]) < 0;
+        failed |= fprintf(file, "\n") < 0;
+    }
+
+    written++;
+}
+
+bool TelemetryRecorder::close(){
+
+    if(file == NULL)
+        return true;
+
+    stopping = true;
+    writer.join();
+
+    // Intervals dropped at the very end never had a later sample to carry their gap row
+    if(gap.dropped > 0)
+        writeSample(gap);
+    gap.dropped = 0;
+
+    if(json)
+        failed |= fprintf(file, "\n  ],\n  \"dropped_intervals\": %lld\n}\n", dropped) < 0;
+
+    failed |= fclose(file) != 0;
+    file = NULL;
+    return !failed && dropped == 0;
+}
@@ -0,0 +1,73 @@
+#include <string>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+#include "PipelineStats.h"
+#include "SpscRing.h"
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+// Intervals buffered between the simulation and the writer thread: enough for TELEMETRY_RING_CYCLES
+// cycles of simulation, within [TELEMETRY_RING_MIN, TELEMETRY_RING_MAX] intervals
+#define TELEMETRY_RING_CYCLES (1LL << 28)
+#define TELEMETRY_RING_MIN 4096
+#define TELEMETRY_RING_MAX 65536
+
+// What happened during one interval of the simulation, deltas only
+struct IntervalSample {
+    long long startCycle;                   // first cycle of the interval
+    long long cycles;
+    long long retired[5];                   // indexed by InstructionType
+    long long stalls[STALL_CAUSE_COUNT];    // cycles stalled by each cause
+    long long dropped;                      // 0, or the number of intervals lost if this marks a gap
+};
+
+/**
+ * Streams interval samples to a CSV or JSON time series
+ * The simulation hands samples over through a preallocated SpscRing and never waits for the file;
+ * a writer thread formats and writes them. If the writer falls a whole ring behind, samples are
+ * dropped and counted instead of stalling the simulation, and one gap row covers their cycles.
+*/
+class TelemetryRecorder {
+  private:
+    FILE *file;
+    bool json;
+    long long interval;
+    std::unique_ptr<SpscRing<IntervalSample>> ring;
+
+    std::thread writer;
+    std::atomic<bool> stopping;
+    long long written, dropped;
+    bool failed;
+
+    // Intervals dropped since the last one queued, owned by the simulation thread
+    IntervalSample gap;
+
+    void drain();
+    void writeSample(const IntervalSample &sample);
+
+  public:
+    // Constructor
+    TelemetryRecorder();
+    ~TelemetryRecorder();
+
+    // Creates path (JSON if it ends in ".json", CSV otherwise) and starts the writer, returns false on failure
+    bool open(const std::string &path, long long intervalCycles);
+
+    // Cycles per interval, as passed to open()
+    long long getInterval() const;
+
+    // Queues sample for the writer without blocking, returns false if it had to be dropped
+    bool record(const IntervalSample &sample);
+
+    // Writes everything recorded and closes the file, returns false if anything failed
+    bool close();
+
+    // Samples lost because the writer fell a whole ring behind
+    long long droppedSamples() const;
+};
+
+#endif
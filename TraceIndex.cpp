@@ -0,0 +1,142 @@
+#include "TraceIndex.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#define TRACE_INDEX_MAGIC "PSIMIDX"
+#define TRACE_INDEX_VERSION 2
+
+// Bytes hashed at each end of the trace
+#define TRACE_INDEX_HASH_BYTES 65536
+
+struct TraceIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t stride;
+    uint64_t trace_size;
+    int64_t trace_mtime;
+    int64_t trace_mtime_nsec;
+    uint64_t trace_hash;
+    uint64_t entry_count;
+};
+
+// Sub-second part of the modification time, 0 where stat doesn't have it
+static int64_t mtime_nsec(const struct stat &st) {
+#if defined(__APPLE__)
+    return st.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    (void)st;
+    return 0;
+#else
+    return st.st_mtim.tv_nsec;
+#endif
+}
+
+// FNV-1a of the first and last TRACE_INDEX_HASH_BYTES of the trace, 0 if it can't be read
+static uint64_t edge_hash(const std::string &trace_path, uint64_t size) {
+    FILE *file = fopen(trace_path.c_str(), "rb");
+    if (file == NULL)
+        return 0;
+
+    std::vector<unsigned char> bytes(TRACE_INDEX_HASH_BYTES);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    bool ok = true;
+    for (int end = 0; end < 2 && ok; end++) {
+        uint64_t start = end && size > TRACE_INDEX_HASH_BYTES ? size - TRACE_INDEX_HASH_BYTES : 0;
+        ok = fseek(file, (long)start, SEEK_SET) == 0;
+        size_t n = ok ? fread(bytes.data(), 1, bytes.size(), file) : 0;
+        for (size_t i = 0; i < n; i++)
+            hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    fclose(file);
+    return ok ? hash : 0;
+}
+
+TraceIndex::TraceIndex(const std::string &trace_path) {
+    index_path = trace_path + ".idx";
+    trace_size = 0;
+    trace_mtime = trace_mtime_nsec = 0;
+    trace_hash = 0;
+    dirty = false;
+
+    // Offset of the first instruction
+    offsets.push_back(0);
+
+    struct stat st;
+    if (stat(trace_path.c_str(), &st) != 0)
+        return;
+    trace_size = st.st_size;
+    trace_mtime = st.st_mtime;
+    trace_mtime_nsec = mtime_nsec(st);
+    trace_hash = edge_hash(trace_path, trace_size);
+
+    FILE *file = fopen(index_path.c_str(), "rb");
+    if (file == NULL)
+        return;
+
+    TraceIndexHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, TRACE_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == TRACE_INDEX_VERSION && header.stride == TRACE_INDEX_STRIDE &&
+        header.trace_size == trace_size && header.trace_mtime == trace_mtime && header.trace_mtime_nsec == trace_mtime_nsec &&
+        header.trace_hash == trace_hash && header.entry_count > 0;
+
+    if (valid) {
+        std::vector<uint64_t> stored(header.entry_count);
+        if (fread(stored.data(), sizeof(uint64_t), stored.size(), file) == stored.size())
+            offsets.swap(stored);
+    }
+    fclose(file);
+}
+
+uint64_t TraceIndex::covered_lines() {
+    return (offsets.size() - 1) * (uint64_t)TRACE_INDEX_STRIDE;
+}
+
+uint64_t TraceIndex::lookup(uint64_t line, uint64_t &offset) {
+    uint64_t k = line / TRACE_INDEX_STRIDE;
+    if (k >= offsets.size())
+        k = offsets.size() - 1;
+
+    offset = offsets[k];
+    return k * TRACE_INDEX_STRIDE;
+}
+
+void TraceIndex::record(uint64_t line, uint64_t offset) {
+    if (line % TRACE_INDEX_STRIDE == 0 && line / TRACE_INDEX_STRIDE == offsets.size()) {
+        offsets.push_back(offset);
+        dirty = true;
+    }
+}
+
+// This function writes the index next to the trace through a temporary file
+void TraceIndex::save() {
+    if (!dirty || trace_size == 0)
+        return;
+
+    TraceIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = TRACE_INDEX_VERSION;
+    header.stride = TRACE_INDEX_STRIDE;
+    header.trace_size = trace_size;
+    header.trace_mtime = trace_mtime;
+    header.trace_mtime_nsec = trace_mtime_nsec;
+    header.trace_hash = trace_hash;
+    header.entry_count = offsets.size();
+
+    std::string tmp_path = index_path + ".tmp";
+    FILE *file = fopen(tmp_path.c_str(), "wb");
+    if (file == NULL)
+        return;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file) == offsets.size();
+    ok = fclose(file) == 0 && ok;
+
+    if (ok && rename(tmp_path.c_str(), index_path.c_str()) == 0)
+        dirty = false;
+    else
+        remove(tmp_path.c_str());
+}
@@ -0,0 +1,47 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#ifndef TRACE_INDEX_H_
+#define TRACE_INDEX_H_
+
+// Instructions between two index entries
+#define TRACE_INDEX_STRIDE 65536
+
+/**
+ * Sidecar index for text traces ("<trace>.idx")
+ * Entry k holds the byte offset of instruction k * TRACE_INDEX_STRIDE + 1, so seeking to any
+ * starting instruction only has to skip fewer than TRACE_INDEX_STRIDE lines.
+ * The index covers as much of the trace as has been skipped over so far and is extended as
+ * later runs skip further; it is discarded when the trace's size, modification time (to the
+ * nanosecond where the platform keeps it) or the hash of its first and last 64 KB change, so a
+ * trace rewritten within the same second at the same size is not read through a stale index.
+*/
+class TraceIndex {
+  private:
+    std::string index_path;
+    uint64_t trace_size;
+    int64_t trace_mtime;
+    int64_t trace_mtime_nsec;
+    uint64_t trace_hash;
+    std::vector<uint64_t> offsets;
+    bool dirty;
+
+  public:
+    // Constructor, loads the sidecar index of trace_path if it is still valid
+    TraceIndex(const std::string &trace_path);
+
+    // Number of leading instructions the index can seek over
+    uint64_t covered_lines();
+
+    // Closest indexed point at or before line (0-based), returns its line and sets offset
+    uint64_t lookup(uint64_t line, uint64_t &offset);
+
+    // Records the byte offset of line (0-based), only stride boundaries right after the covered range are kept
+    void record(uint64_t line, uint64_t offset);
+
+    // Writes the index back if it grew, failures are ignored (e.g. read-only trace directory)
+    void save();
+};
+
+#endif
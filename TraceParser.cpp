@@ -0,0 +1,520 @@
+#include "TraceParser.h"
+#include "BinaryTrace.h"
+#include "TraceTokenizer.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef TRACE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef TRACE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Size of the fallback read buffer, also the longest line it can hold
+#define TRACE_CHUNK_SIZE (1 << 20)
+
+// Compressed bytes read from the file at a time
+#define TRACE_COMPRESSED_CHUNK_SIZE (1 << 18)
+
+// Value of every byte as a hex digit, -1 if it is none
+struct HexTable {
+    signed char value[256];
+};
+
+static HexTable buildHexTable(){
+
+    HexTable table;
+    memset(table.value, -1, sizeof(table.value));
+    for(int i = 0; i < 10; i++)
+        table.value['0' + i] = i;
+    for(int i = 0; i < 6; i++)
+        table.value['a' + i] = table.value['A' + i] = 10 + i;
+    return table;
+}
+
+// Built once on first use; C++11 makes the initialization thread-safe, so parsers may be created concurrently
+static const signed char *hexTable(){
+    static const HexTable table = buildHexTable();
+    return table.value;
+}
+
+TraceParser::TraceParser() {
+    data = cur = end = NULL;
+    mapped_size = 0;
+    file = NULL;
+    file_eof = true;
+    bytes_consumed = lines_consumed = 0;
+    malformed = false;
+    use_tokenizer = tokenizer_available();
+    tokenizer = tokenizer_kind();
+    binary = false;
+    compression = COMPRESSION_NONE;
+    stream = NULL;
+    compressed_file = NULL;
+    compressed_pos = compressed_size = 0;
+    stream_end = true;
+}
+
+TraceParser::~TraceParser() {
+    close();
+}
+
+/**
+ * Recognize a compressed file by its first bytes
+*/
+static bool detectCompression(const std::string &path, int &compression) {
+    FILE *probe = fopen(path.c_str(), "rb");
+    if (probe == NULL)
+        return false;
+
+    unsigned char magic[4] = {0, 0, 0, 0};
+    size_t got = fread(magic, 1, sizeof(magic), probe);
+    fclose(probe);
+
+    if (got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        compression = 1;    // gzip
+    else if (got == 4 && memcmp(magic, "PK\x03\x04", 4) == 0)
+        compression = 2;    // zip local file header
+    else if (got == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        compression = 3;    // zstd frame
+    else
+        compression = 0;
+    return true;
+}
+
+// This function maps the trace file, or opens it for chunked reading if mapping fails
+bool TraceParser::open(const std::string &path) {
+    close();
+    malformed = false;
+    bytes_consumed = lines_consumed = 0;
+
+    int detected;
+    if (!detectCompression(path, detected))
+        return false;
+    if (detected != 0)
+        return open_compressed(path, static_cast<Compression>(detected));
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            ::close(fd);
+            mapped_size = st.st_size;
+            data = cur = static_cast<const char*>(p);
+            end = data + mapped_size;
+
+            binary = isBinaryTrace(data, mapped_size);
+            if (binary)
+                cur += sizeof(BinaryTraceHeader);
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    chunk.resize(TRACE_CHUNK_SIZE);
+    data = cur = end = chunk.data();
+    file_eof = false;
+
+    refill();
+    binary = isBinaryTrace(cur, end - cur);
+    if (binary)
+        cur += sizeof(BinaryTraceHeader);
+    return true;
+}
+
+/**
+ * Set up streaming decompression of path into the chunk buffer
+ * gzip streams may hold several members, a zip file is read up to the end of its first entry
+ * @returns false if the file can't be read or this build can't decode it
+*/
+bool TraceParser::open_compressed(const std::string &path, Compression compression) {
+    compressed_file = fopen(path.c_str(), "rb");
+    if (compressed_file == NULL)
+        return false;
+
+    this->compression = compression;
+    compressed.resize(TRACE_COMPRESSED_CHUNK_SIZE);
+    compressed_pos = compressed_size = 0;
+    stream_end = false;
+
+    bool ready = false;
+#ifdef TRACE_HAVE_ZLIB
+    if (compression == COMPRESSION_GZIP || compression == COMPRESSION_ZIP) {
+        int window = 16 + MAX_WBITS;    // gzip wrapper
+
+        // Zip local file header: 30 fixed bytes, then name and extra field, then the raw deflate data
+        if (compression == COMPRESSION_ZIP) {
+            unsigned char header[30];
+            window = -MAX_WBITS;
+            ready = fread(header, 1, sizeof(header), compressed_file) == sizeof(header) &&
+                (header[8] | header[9] << 8) == 8 &&
+                fseek(compressed_file, (header[26] | header[27] << 8) + (header[28] | header[29] << 8), SEEK_CUR) == 0;
+        } else {
+            ready = true;
+        }
+
+        z_stream *z = new z_stream();
+        stream = z;
+        ready = ready && inflateInit2(z, window) == Z_OK;
+        if (!ready) {
+            delete z;
+            stream = NULL;
+        }
+    }
+#endif
+#ifdef TRACE_HAVE_ZSTD
+    if (compression == COMPRESSION_ZSTD) {
+        stream = ZSTD_createDCtx();
+        ready = stream != NULL;
+    }
+#endif
+
+    if (!ready) {
+        close();
+        return false;
+    }
+
+    chunk.resize(TRACE_CHUNK_SIZE);
+    data = cur = end = chunk.data();
+    file_eof = false;
+
+    refill();
+    binary = isBinaryTrace(cur, end - cur);
+    if (binary)
+        cur += sizeof(BinaryTraceHeader);
+    return true;
+}
+
+/**
+ * Decompress up to n bytes into dst
+ * @returns bytes produced, 0 once the compressed stream ended (or is corrupt, which also sets malformed)
+*/
+size_t TraceParser::read_stream(char *dst, size_t n) {
+    size_t produced = 0;
+
+    while (produced == 0 && !stream_end) {
+        if (compressed_pos == compressed_size) {
+            compressed_size = fread(compressed.data(), 1, compressed.size(), compressed_file);
+            compressed_pos = 0;
+            if (compressed_size == 0) {
+                stream_end = true;
+                break;
+            }
+        }
+
+#ifdef TRACE_HAVE_ZLIB
+        if (compression == COMPRESSION_GZIP || compression == COMPRESSION_ZIP) {
+            z_stream *z = static_cast<z_stream*>(stream);
+            z->next_in = reinterpret_cast<Bytef*>(compressed.data() + compressed_pos);
+            z->avail_in = compressed_size - compressed_pos;
+            z->next_out = reinterpret_cast<Bytef*>(dst);
+            z->avail_out = n;
+
+            int ret = inflate(z, Z_NO_FLUSH);
+            compressed_pos = compressed_size - z->avail_in;
+            produced = n - z->avail_out;
+
+            if (ret == Z_STREAM_END) {
+                // Another gzip member may follow, a zip entry is complete
+                if (compression == COMPRESSION_GZIP)
+                    inflateReset(z);
+                else
+                    stream_end = true;
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                malformed = true;
+                stream_end = true;
+            }
+        }
+#endif
+#ifdef TRACE_HAVE_ZSTD
+        if (compression == COMPRESSION_ZSTD) {
+            ZSTD_inBuffer in = {compressed.data(), compressed_size, compressed_pos};
+            ZSTD_outBuffer out = {dst, n, 0};
+            size_t ret = ZSTD_decompressStream(static_cast<ZSTD_DCtx*>(stream), &out, &in);
+            compressed_pos = in.pos;
+            produced = out.pos;
+            if (ZSTD_isError(ret)) {
+                malformed = true;
+                stream_end = true;
+            }
+        }
+#endif
+    }
+
+    return produced;
+}
+
+// This function moves the unparsed tail to the front of the chunk and reads more after it
+bool TraceParser::refill() {
+    if ((file == NULL && compression == COMPRESSION_NONE) || file_eof)
+        return false;
+
+    size_t left = end - cur;
+    memmove(chunk.data(), cur, left);
+    size_t got = compression != COMPRESSION_NONE ? read_stream(chunk.data() + left, chunk.size() - left)
+        : fread(chunk.data() + left, 1, chunk.size() - left, file);
+    if (got == 0)
+        file_eof = true;
+
+    cur = chunk.data();
+    end = cur + left + got;
+    return got != 0;
+}
+
+// This function returns the end of the current line ('\n' or end of file), NULL once the file is exhausted
+const char *TraceParser::find_line_end() {
+    while (true) {
+        const char *nl = static_cast<const char*>(memchr(cur, '\n', end - cur));
+        if (nl != NULL)
+            return nl;
+        if (!refill())
+            return cur != end ? end : NULL;
+    }
+}
+
+bool TraceParser::at_end() {
+    return find_line_end() == NULL;
+}
+
+void TraceParser::set_tokenizer(bool enabled) {
+    use_tokenizer = enabled && tokenizer_available();
+}
+
+void TraceParser::set_tokenizer_kind(TokenizerKind kind) {
+    tokenizer = kind;
+}
+
+bool TraceParser::is_binary() {
+    return binary;
+}
+
+bool TraceParser::is_compressed() {
+    return compression != COMPRESSION_NONE;
+}
+
+// This function skips n lines without decoding them
+bool TraceParser::skip_lines(uint64_t n) {
+    if (binary)
+        return skip_binary(n);
+
+    for (uint64_t i = 0; i < n; i++) {
+        const char *line_end = find_line_end();
+        if (line_end == NULL)
+            return false;
+
+        const char *next = line_end == end ? end : line_end + 1;
+        bytes_consumed += next - cur;
+        lines_consumed++;
+        cur = next;
+    }
+    return true;
+}
+
+// This function repositions a text trace at a known line start, e.g. from a TraceIndex
+bool TraceParser::seek(uint64_t offset, uint64_t line) {
+    if (binary || compression != COMPRESSION_NONE)
+        return false;
+
+    if (file == NULL) {
+        if (offset > mapped_size)
+            return false;
+        cur = data + offset;
+    } else {
+        if (fseek(file, offset, SEEK_SET) != 0)
+            return false;
+        cur = end = chunk.data();
+        file_eof = false;
+        refill();
+    }
+
+    bytes_consumed = offset;
+    lines_consumed = line;
+    return true;
+}
+
+// This function decodes "pc,type[,dep]..." straight into record
+bool TraceParser::next(TraceRecord &record) {
+    if (binary)
+        return next_binary(record);
+
+    // Common lines are decoded a field per vector load, the rest falls through to the byte loop below
+    if (use_tokenizer && end - cur >= TRACE_TOKEN_READABLE) {
+        size_t length = tokenize_line_with(tokenizer, cur, record);
+        if (length != 0) {
+            bytes_consumed += length;
+            lines_consumed++;
+            cur += length;
+            return true;
+        }
+    }
+
+    const char *line_end = find_line_end();
+    if (line_end == NULL)
+        return false;
+
+    const signed char *hex = hexTable();
+    const char *p = cur;
+
+    // Program counter
+    if (line_end - p > 1 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        p += 2;
+    uint64_t pc = 0;
+    const char *digits = p;
+    while (p < line_end && hex[(unsigned char)*p] >= 0)
+        pc = (pc << 4) | hex[(unsigned char)*p++];
+
+    // Type, a single digit between 1 and 5
+    bool ok = p != digits && p + 1 < line_end && p[0] == ',' && p[1] >= '1' && p[1] <= '5';
+    if (ok) {
+        record.program_counter = pc;
+        record.type = p[1] - '1';
+        record.dependency_count = 0;
+        p += 2;
+
+        // Dependencies
+        while (ok && p < line_end && *p == ',') {
+            p++;
+            if (line_end - p > 1 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+                p += 2;
+            uint64_t dep = 0;
+            digits = p;
+            while (p < line_end && hex[(unsigned char)*p] >= 0)
+                dep = (dep << 4) | hex[(unsigned char)*p++];
+
+            // Trailing comma, nothing left to decode
+            if (p == digits && (p == line_end || *p == '\r'))
+                break;
+
+            ok = p != digits && record.dependency_count < TRACE_MAX_DEPENDENCIES;
+            if (ok)
+                record.dependencies[record.dependency_count++] = dep;
+        }
+
+        ok = ok && (p == line_end || (*p == '\r' && p + 1 == line_end));
+    }
+
+    if (!ok) {
+        malformed = true;
+        return false;
+    }
+
+    const char *next = line_end == end ? end : line_end + 1;
+    bytes_consumed += next - cur;
+    lines_consumed++;
+    cur = next;
+    return true;
+}
+
+// This function copies the next fixed-width record out of the binary trace
+bool TraceParser::next_binary(TraceRecord &record) {
+    if ((size_t)(end - cur) < sizeof(TraceRecord))
+        refill();
+    if ((size_t)(end - cur) < sizeof(TraceRecord))
+        return false;
+
+    memcpy(&record, cur, sizeof(TraceRecord));
+    if (record.type > 4 || record.dependency_count > TRACE_MAX_DEPENDENCIES) {
+        malformed = true;
+        return false;
+    }
+
+    cur += sizeof(TraceRecord);
+    bytes_consumed += sizeof(TraceRecord);
+    lines_consumed++;
+    return true;
+}
+
+// This function skips n binary records, seeking instead of reading where possible
+bool TraceParser::skip_binary(uint64_t n) {
+    uint64_t bytes = n * sizeof(TraceRecord);
+    uint64_t buffered = end - cur;
+
+    if (bytes <= buffered) {
+        cur += bytes;
+    } else if (compression != COMPRESSION_NONE) {
+        // Decompress and drop what is skipped
+        uint64_t left = bytes - buffered;
+        cur = end;
+        while (left > 0) {
+            if (!refill())
+                return false;
+            size_t taken = std::min<uint64_t>(left, end - cur);
+            cur += taken;
+            left -= taken;
+        }
+    } else {
+        if (file == NULL || fseek(file, bytes - buffered, SEEK_CUR) != 0)
+            return false;
+        cur = end;
+        refill();
+        if ((size_t)(end - cur) < sizeof(TraceRecord))
+            return false;
+    }
+
+    bytes_consumed += bytes;
+    lines_consumed += n;
+    return true;
+}
+
+uint64_t TraceParser::bytes_read() {
+    return bytes_consumed;
+}
+
+uint64_t TraceParser::lines_read() {
+    return lines_consumed;
+}
+
+// This function unmaps or closes the trace file
+void TraceParser::close() {
+#ifndef _WIN32
+    if (mapped_size != 0)
+        munmap(const_cast<char*>(data), mapped_size);
+#endif
+    if (file != NULL)
+        fclose(file);
+
+#ifdef TRACE_HAVE_ZLIB
+    if (stream != NULL && (compression == COMPRESSION_GZIP || compression == COMPRESSION_ZIP)) {
+        inflateEnd(static_cast<z_stream*>(stream));
+        delete static_cast<z_stream*>(stream);
+    }
+#endif
+#ifdef TRACE_HAVE_ZSTD
+    if (stream != NULL && compression == COMPRESSION_ZSTD)
+        ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(stream));
+#endif
+    if (compressed_file != NULL)
+        fclose(compressed_file);
+
+    compression = COMPRESSION_NONE;
+    stream = NULL;
+    compressed_file = NULL;
+    stream_end = true;
+
+    mapped_size = 0;
+    file = NULL;
+    file_eof = true;
+    binary = false;
+    data = cur = end = NULL;
+}
@@ -0,0 +1,110 @@
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include "TraceTokenizer.h"
+
+#ifndef TRACE_PARSER_H_
+#define TRACE_PARSER_H_
+
+#define TRACE_MAX_DEPENDENCIES 4
+
+/**
+ * One decoded trace line, plain integers only
+*/
+struct TraceRecord {
+    uint64_t program_counter;
+    unsigned char type;                 // InstructionType index, 0 - 4
+    unsigned char dependency_count;
+    unsigned char reserved[6];
+    uint64_t dependencies[TRACE_MAX_DEPENDENCIES];
+};
+
+/**
+ * Zero-copy trace parser
+ * Maps the trace file and decodes lines in place; falls back to a fixed chunk buffer
+ * where mmap is unavailable. Nothing is allocated per line.
+ * Binary traces (see BinaryTrace.h) are detected on open and read record by record instead.
+ * Compressed traces (gzip or a single-entry zip, zstd when built with TRACE_HAVE_ZSTD) are detected
+ * by their magic bytes and decompressed as a stream into the chunk buffer; they can't seek.
+*/
+class TraceParser {
+  private:
+    // Mapped file (or chunk buffer) and the unparsed part of it
+    const char *data;
+    const char *cur;
+    const char *end;
+    size_t mapped_size;
+
+    // Chunked fallback
+    FILE *file;
+    std::vector<char> chunk;
+    bool file_eof;
+
+    uint64_t bytes_consumed;
+    uint64_t lines_consumed;
+    bool use_tokenizer;
+    TokenizerKind tokenizer;
+
+    // Compressed input: decoder state (z_stream or ZSTD_DCtx, opaque so their headers stay out of here)
+    // and the compressed bytes read from compressed_file but not decoded yet
+    enum Compression { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZIP, COMPRESSION_ZSTD };
+    Compression compression;
+    void *stream;
+    FILE *compressed_file;
+    std::vector<char> compressed;
+    size_t compressed_pos, compressed_size;
+    bool stream_end;
+    bool open_compressed(const std::string &path, Compression compression);
+    size_t read_stream(char *dst, size_t n);
+
+    // Fixed-width records instead of text lines
+    bool binary;
+    bool next_binary(TraceRecord &record);
+    bool skip_binary(uint64_t n);
+
+    // Makes sure [cur, end) holds a complete line unless the file is exhausted
+    const char *find_line_end();
+    bool refill();
+
+  public:
+    // Constructor
+    TraceParser();
+    ~TraceParser();
+
+    // Opens the trace, returns false on failure
+    bool open(const std::string &path);
+
+    // Whether the opened trace is in the binary format
+    bool is_binary();
+
+    // Whether the opened trace is decompressed on the fly, such traces can only be read front to back
+    bool is_compressed();
+
+    // Skips n lines, returns false if the file ends first
+    bool skip_lines(uint64_t n);
+
+    // Jumps to byte offset of a text trace, which must be the start of 0-based line
+    bool seek(uint64_t offset, uint64_t line);
+
+    // Decodes the next line into record, returns false at end of file or on a malformed line
+    bool next(TraceRecord &record);
+
+    // Whether text lines go through the vectorized tokenizer (TraceTokenizer.h) first, on where it is built in
+    void set_tokenizer(bool enabled);
+
+    // Tokenizer variant to use instead of the best one the CPU has, which must be tokenizer_supported
+    void set_tokenizer_kind(TokenizerKind kind);
+
+    bool at_end();
+    bool malformed;
+
+    // Bytes and lines consumed so far (skipped lines included)
+    uint64_t bytes_read();
+    uint64_t lines_read();
+
+    void close();
+};
+
+#endif
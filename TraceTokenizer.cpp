@@ -0,0 +1,175 @@
+#include "TraceTokenizer.h"
+#include "TraceParser.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <immintrin.h>
+#define TRACE_TOKENIZER_SIMD 1
+#endif
+
+#ifdef TRACE_TOKENIZER_SIMD
+
+/**
+ * Value of every byte of c that is a hex digit (0 for the others), and a mask of those bytes
+ * '0'-'9' and, case folded, 'a'-'f' are the only bytes landing in 0-9 and 0-5 respectively
+*/
+static inline __m128i hex_digits(__m128i c, int &mask) {
+    __m128i decimal = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i is_decimal = _mm_cmpeq_epi8(_mm_min_epu8(decimal, _mm_set1_epi8(9)), decimal);
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    mask = _mm_movemask_epi8(_mm_or_si128(is_decimal, is_letter));
+    return _mm_or_si128(_mm_and_si128(is_decimal, decimal), _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+// Value of the first n (1 - 16) of 8 packed digit pairs, most significant first
+static inline uint64_t pair_value(__m128i pairs, int n) {
+    uint64_t bytes;
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&bytes), _mm_packus_epi16(pairs, _mm_setzero_si128()));
+    return __builtin_bswap64(bytes) >> ((64 - 4 * n) & 63);
+}
+
+/**
+ * Reads the run of hex digits at text (16 readable bytes) into value
+ * @return its length, 16 if it may be longer
+*/
+static inline int scan_sse2(const char *text, uint64_t &value) {
+    int mask;
+    __m128i digit = hex_digits(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text)), mask);
+    int n = __builtin_ctz(~mask);
+
+    // Each byte pair (high digit first) becomes one 16-bit value
+    __m128i high = _mm_and_si128(_mm_slli_epi16(digit, 4), _mm_set1_epi16(0x00f0));
+    value = pair_value(_mm_or_si128(high, _mm_srli_epi16(digit, 8)), n);
+    return n;
+}
+
+// Same as scan_sse2, but SSSE3's byte multiply-add joins each pair in one instruction
+__attribute__((target("ssse3")))
+static inline int scan_ssse3(const char *text, uint64_t &value) {
+    int mask;
+    __m128i digit = hex_digits(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text)), mask);
+    int n = __builtin_ctz(~mask);
+
+    value = pair_value(_mm_maddubs_epi16(digit, _mm_set1_epi16(0x0110)), n);
+    return n;
+}
+
+/**
+ * Walks the fields of the line, Scan decodes each one
+ * Every field is checked for what the scalar parser accepts, anything unusual returns 0
+*/
+template<int (*Scan)(const char*, uint64_t&)>
+__attribute__((always_inline))
+static inline size_t tokenize(const char *line, TraceRecord &record) {
+    const char *p = line;
+    uint64_t value;
+
+    // Program counter
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        p += 2;
+    int n = Scan(p, value);
+    if (n == 0 || n == 16)
+        return 0;
+    p += n;
+
+    // Type, a single digit between 1 and 5
+    if (p[0] != ',' || p[1] < '1' || p[1] > '5')
+        return 0;
+    record.program_counter = value;
+    record.type = p[1] - '1';
+    record.dependency_count = 0;
+    p += 2;
+
+    // Dependencies
+    while (*p == ',') {
+        p++;
+        if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+            p += 2;
+        n = Scan(p, value);
+        if (n == 0 || n == 16 || record.dependency_count == TRACE_MAX_DEPENDENCIES)
+            return 0;
+        record.dependencies[record.dependency_count++] = value;
+        p += n;
+    }
+
+    if (*p == '\r')
+        p++;
+    return *p == '\n' ? p + 1 - line : 0;
+}
+
+__attribute__((target("ssse3")))
+static size_t tokenize_ssse3(const char *line, TraceRecord &record) {
+    return tokenize<scan_ssse3>(line, record);
+}
+
+static size_t tokenize_sse2(const char *line, TraceRecord &record) {
+    return tokenize<scan_sse2>(line, record);
+}
+
+typedef size_t (*Tokenizer)(const char *line, TraceRecord &record);
+
+// Indexed by TokenizerKind
+static const Tokenizer tokenizers[TOKENIZER_KINDS] = {tokenize_sse2, tokenize_ssse3};
+
+// SSSE3 where the CPU has it, decided on first use
+static TokenizerKind selected_kind() {
+    static const TokenizerKind selected = __builtin_cpu_supports("ssse3") ? TOKENIZER_SSSE3 : TOKENIZER_SSE2;
+    return selected;
+}
+
+size_t tokenize_line(const char *line, TraceRecord &record) {
+    return tokenizers[selected_kind()](line, record);
+}
+
+size_t tokenize_line_with(TokenizerKind kind, const char *line, TraceRecord &record) {
+    return tokenizers[kind](line, record);
+}
+
+TokenizerKind tokenizer_kind() {
+    return selected_kind();
+}
+
+const char *tokenizer_name() {
+    return tokenizer_kind_name(selected_kind());
+}
+
+bool tokenizer_available() {
+    return true;
+}
+
+bool tokenizer_supported(TokenizerKind kind) {
+    return kind == TOKENIZER_SSE2 || (kind == TOKENIZER_SSSE3 && __builtin_cpu_supports("ssse3"));
+}
+
+#else
+
+size_t tokenize_line(const char *, TraceRecord &) {
+    return 0;
+}
+
+size_t tokenize_line_with(TokenizerKind, const char *, TraceRecord &) {
+    return 0;
+}
+
+TokenizerKind tokenizer_kind() {
+    return TOKENIZER_SSE2;
+}
+
+const char *tokenizer_name() {
+    return "scalar";
+}
+
+bool tokenizer_available() {
+    return false;
+}
+
+bool tokenizer_supported(TokenizerKind) {
+    return false;
+}
+
+#endif
+
+const char *tokenizer_kind_name(TokenizerKind kind) {
+    return kind == TOKENIZER_SSSE3 ? "ssse3" : "sse2";
+}
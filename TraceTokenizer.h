@@ -0,0 +1,52 @@
+#include <cstddef>
+
+#ifndef TRACE_TOKENIZER_H_
+#define TRACE_TOKENIZER_H_
+
+struct TraceRecord;
+
+// Bytes that must be readable from the start of a line handed to tokenize_line
+#define TRACE_TOKEN_READABLE 128
+
+/**
+ * Vectorized decoder of "pc,type[,dep]..." text lines
+ * Every field is decoded from one 16-byte load: the hex digits are classified and converted to
+ * their values all at once, the field's length is the count of leading digits in the resulting
+ * mask and up to 16 digits are packed into a 64-bit value without a per-digit loop. The line is
+ * found and checked field by field, so there is no separate search for its end.
+ * SSE2 is the baseline; where the CPU has SSSE3 (checked once at runtime) digit pairs are packed with
+ * its byte multiply-add instead of shifts.
+ * Only the common well-formed lines are decoded here; everything else (fields of 16 or more
+ * digits, trailing commas, malformed lines) is left to the scalar parser in TraceParser::next,
+ * which decides them exactly as before.
+*/
+
+// Vectorized variants, tokenize_line uses the best one the CPU supports
+enum TokenizerKind { TOKENIZER_SSE2, TOKENIZER_SSSE3, TOKENIZER_KINDS };
+
+/**
+ * Decodes the line starting at line into record
+ * TRACE_TOKEN_READABLE bytes from line must be readable
+ * @return bytes of the line including its '\n', 0 if the scalar parser has to decode it
+*/
+size_t tokenize_line(const char *line, TraceRecord &record);
+
+// tokenize_line with the given variant, which must be tokenizer_supported
+size_t tokenize_line_with(TokenizerKind kind, const char *line, TraceRecord &record);
+
+// Variant tokenize_line uses, only meaningful if tokenizer_available
+TokenizerKind tokenizer_kind();
+
+// "ssse3", "sse2", or "scalar" where no vectorized tokenizer is built in
+const char *tokenizer_name();
+
+// "sse2" or "ssse3"
+const char *tokenizer_kind_name(TokenizerKind kind);
+
+// Whether tokenize_line can decode anything at all on this build
+bool tokenizer_available();
+
+// Whether kind is built in and the CPU can run it
+bool tokenizer_supported(TokenizerKind kind);
+
+#endif
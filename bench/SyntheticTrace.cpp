@@ -0,0 +1,170 @@
+#include <cstdio>
+
+#include "SyntheticTrace.h"
+#include "../BinaryTrace.h"
+
+using namespace std;
+
+// Base of the generated code region
+#define SYNTHETIC_CODE_BASE 0x400000
+
+// How far back dependencies can reach
+#define SYNTHETIC_HISTORY 256
+
+SyntheticTraceConfig::SyntheticTraceConfig(){
+    length = 1000000;
+    mix[0] = 45;
+    mix[1] = 10;
+    mix[2] = 0;
+    mix[3] = 25;
+    mix[4] = 10;
+    branchDensity = 0.15;
+    dependencyDistance = 4;
+    dependenciesPerInst = 1.2;
+    codeSize = 4096;
+    seed = 1;
+}
+
+namespace {
+
+/**
+ * splitmix64, small and fully specified so traces are reproducible everywhere
+*/
+class SyntheticRandom {
+  private:
+    uint64_t state;
+
+  public:
+    SyntheticRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next(){
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1)
+    double uniform(){
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform in [0, n)
+    uint64_t below(uint64_t n){
+        return n ? next() % n : 0;
+    }
+
+    // Geometric number of trials until success with the given mean, at least 1
+    uint64_t geometric(double mean){
+        if(mean <= 1)
+            return 1;
+
+        double p = 1.0 / mean;
+        uint64_t trials = 1;
+        while(uniform() >= p && trials < SYNTHETIC_HISTORY)
+            trials++;
+        return trials;
+    }
+};
+
+/**
+ * Picks a non-branch InstructionType index according to mix
+*/
+unsigned char pickType(const double mix[5], SyntheticRandom &random){
+
+    double total = mix[0] + mix[1] + mix[3] + mix[4];
+    if(total <= 0)
+        return 0;
+
+    double x = random.uniform() * total;
+    const unsigned char types[4] = {0, 1, 3, 4};
+    for(int i = 0; i < 4; i++){
+        x -= mix[types[i]];
+        if(x < 0)
+            return types[i];
+    }
+    return 4;
+}
+
+}
+
+/**
+ * Walk a code region of codeSize instructions: control falls through sequentially and
+ * every taken branch jumps to a random instruction. Each static instruction keeps one type,
+ * so repeated program counters behave like loop bodies for the producer index.
+ * Dependencies name the program counter of an instruction a geometric distance back.
+*/
+vector<TraceRecord> generateSyntheticTrace(const SyntheticTraceConfig &config){
+
+    SyntheticRandom random(config.seed);
+    uint32_t codeSize = config.codeSize ? config.codeSize : 1;
+
+    // Static code: a type per instruction
+    vector<unsigned char> code(codeSize);
+    for(uint32_t i = 0; i < codeSize; i++)
+        code[i] = random.uniform() < config.branchDensity ? 2 : pickType(config.mix, random);
+
+    vector<TraceRecord> records(config.length);
+    vector<uint64_t> history(SYNTHETIC_HISTORY);
+    double perSlot = config.dependenciesPerInst / TRACE_MAX_DEPENDENCIES;
+    uint32_t at = 0;
+
+    for(uint64_t n = 0; n < config.length; n++){
+
+        TraceRecord &record = records[n];
+        record = TraceRecord();
+        record.program_counter = SYNTHETIC_CODE_BASE + 4 * (uint64_t)at;
+        record.type = code[at];
+
+        for(int i = 0; i < TRACE_MAX_DEPENDENCIES; i++){
+            if(random.uniform() >= perSlot)
+                continue;
+
+            uint64_t distance = random.geometric(config.dependencyDistance);
+            if(distance > n)
+                continue;
+            record.dependencies[record.dependency_count++] = history[(n - distance) % SYNTHETIC_HISTORY];
+        }
+
+        history[n % SYNTHETIC_HISTORY] = record.program_counter;
+
+        // Taken about half the time
+        if(record.type == 2 && (random.next() & 1))
+            at = (uint32_t)random.below(codeSize);
+        else
+            at = at + 1 == codeSize ? 0 : at + 1;
+    }
+
+    return records;
+}
+
+bool writeTextTrace(const string &path, const vector<TraceRecord> &records){
+
+    FILE *file = fopen(path.c_str(), "w");
+    if(file == NULL)
+        return false;
+
+    bool ok = true;
+    for(size_t n = 0; ok && n < records.size(); n++){
+        const TraceRecord &record = records[n];
+        ok = fprintf(file, "%llx,%d", (unsigned long long)record.program_counter, record.type + 1) > 0;
+        for(int i = 0; i < record.dependency_count; i++)
+            ok = ok && fprintf(file, ",%llx", (unsigned long long)record.dependencies[i]) > 0;
+        ok = ok && fputc('\n', file) != EOF;
+    }
+
+    return fclose(file) == 0 && ok;
+}
+
+bool writeBinaryTrace(const string &path, const vector<TraceRecord> &records){
+
+    BinaryTraceWriter writer;
+    if(!writer.open(path))
+        return false;
+
+    bool ok = true;
+    for(size_t n = 0; ok && n < records.size(); n++)
+        ok = writer.write(records[n]);
+
+    return writer.close() && ok;
+}
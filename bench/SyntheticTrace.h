@@ -0,0 +1,36 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "../TraceParser.h"
+
+#ifndef SYNTHETIC_TRACE_H_
+#define SYNTHETIC_TRACE_H_
+
+// Shape of a generated trace
+struct SyntheticTraceConfig {
+    uint64_t length;            // instructions
+    double mix[5];              // relative weight of each InstructionType among non-branch instructions, mix[2] unused
+    double branchDensity;       // fraction of branch instructions
+    double dependencyDistance;  // mean distance back, in instructions, from a consumer to its producer
+    double dependenciesPerInst; // mean number of dependencies per instruction, up to 4
+    uint32_t codeSize;          // distinct program counters
+    uint64_t seed;
+
+    SyntheticTraceConfig();
+};
+
+/**
+ * Generates a trace from config
+ * The same config always produces the same records on every platform
+ * (own PRNG and integer arithmetic, no <random> distributions).
+*/
+std::vector<TraceRecord> generateSyntheticTrace(const SyntheticTraceConfig &config);
+
+// Writes records in the text trace format, returns false on failure
+bool writeTextTrace(const std::string &path, const std::vector<TraceRecord> &records);
+
+// Writes records in the binary trace format, returns false on failure
+bool writeBinaryTrace(const std::string &path, const std::vector<TraceRecord> &records);
+
+#endif
@@ -0,0 +1,370 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "SyntheticTrace.h"
+#include "../ReadInput.h"
+#include "../Simulator.h"
+#include "../EventSimulator.h"
+#include "../Sweep.h"
+#include "../TraceParser.h"
+#include "../TraceTokenizer.h"
+
+using namespace std;
+
+// Options that take a value, everything else starting with "--" is a flag
+static const char *valueOptions[] = {"--length", "--widths", "--mix", "--branch-density", "--dep-distance",
+    "--deps", "--code-size", "--seed", "--repeat", "--dir"};
+
+static bool takesValue(const string &option){
+    for(int i = 0; i < (int)(sizeof(valueOptions) / sizeof(valueOptions[0])); i++)
+        if(option == valueOptions[i])
+            return true;
+    return false;
+}
+
+static const char *flagOptions[] = {"--keep", "--verify-parser"};
+
+static bool isFlag(const string &option){
+    for(int i = 0; i < (int)(sizeof(flagOptions) / sizeof(flagOptions[0])); i++)
+        if(option == flagOptions[i])
+            return true;
+    return false;
+}
+
+// Timing of the fastest repetition of one phase
+struct BenchTiming {
+    double seconds;
+    uint64_t hostCycles;    // 0 where there is no timestamp counter
+};
+
+static uint64_t hostCycleCounter(){
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Peak resident set size of the process so far in MB, 0 where it can't be queried
+*/
+static double peakRssMB(){
+#ifndef _WIN32
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0){
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Run phase repeat times and keep the fastest
+*/
+template<class Phase>
+static BenchTiming timeBest(int repeat, Phase phase){
+
+    BenchTiming best;
+    best.seconds = -1;
+    best.hostCycles = 0;
+
+    for(int r = 0; r < repeat; r++){
+        auto begin = chrono::steady_clock::now();
+        uint64_t cycles = hostCycleCounter();
+        phase();
+        cycles = hostCycleCounter() - cycles;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+        if(best.seconds < 0 || seconds < best.seconds){
+            best.seconds = seconds;
+            best.hostCycles = cycles;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Parse path from start to end once
+*/
+static bool parseOnce(const string &path, uint64_t length){
+    TraceInput input(path, 1, length);
+    if(input.file_failed)
+        return false;
+    ParseThroughput parsed = input.measure_parse();
+    input.close_file();
+    return parsed.lines == length;
+}
+
+/**
+ * Read path with the given tokenizer variant and without any side by side
+ * @return number of lines where the two parsers disagree, counting a different end as one
+*/
+static uint64_t compareTokenizer(const string &path, TokenizerKind kind){
+
+    TraceParser vectorized, scalar;
+    vectorized.set_tokenizer_kind(kind);
+    scalar.set_tokenizer(false);
+    if(!vectorized.open(path) || !scalar.open(path))
+        return 1;
+
+    uint64_t mismatches = 0;
+    while(true){
+        TraceRecord a, b;
+        bool gotA = vectorized.next(a), gotB = scalar.next(b);
+
+        bool same = gotA == gotB && vectorized.malformed == scalar.malformed &&
+            vectorized.lines_read() == scalar.lines_read() && vectorized.bytes_read() == scalar.bytes_read();
+        if(same && gotA){
+            same = a.program_counter == b.program_counter && a.type == b.type && a.dependency_count == b.dependency_count;
+            for(int i = 0; same && i < a.dependency_count; i++)
+                same = a.dependencies[i] == b.dependencies[i];
+        }
+
+        if(!same){
+            mismatches++;
+            if(mismatches <= 5)
+                cerr<<"Tokenizer ("<<tokenizer_kind_name(kind)<<") mismatch at line "<<scalar.lines_read()<<" of "<<path<<endl;
+        }
+        if(!gotA || !gotB)
+            break;
+    }
+
+    vectorized.close();
+    scalar.close();
+    return mismatches;
+}
+
+/**
+ * Lines the tokenizer must leave to the scalar parser or decode exactly like it
+*/
+static const char *tokenizerCases[] = {
+    "400000,1,ABCDEF,0Xabc,0x12", "0x0123456789abcdef,2", "123456789abcdef0,3", "fffffffffffffffff,1",
+    "0x1,4,0x2,", "0x1,5,", "10,1,20\r", "10,1,20\r\r", ",1", "0x,1", "10,6", "10,0", "10,12", "10,1,,20",
+    "10,1,2,3,4,5", "10,1,2,3,4,5,6", "10 ,1", "10,1,0x", "10,1,0xg", "x10,1", "10,1,20,30,40,50\r",
+    "0xffffffffffffffff,1,0xffffffffffffffff,0x0000000000000000001",
+    "0x1234567890abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef,1",
+    "10,1,20"
+};
+
+// Write count ordinary lines to file
+static void writeFillerLines(FILE *file, int count){
+    for(int i = 0; i < count; i++)
+        fprintf(file, "%x,%d,%x\n", 0x400000 + 4 * i, i % 5 + 1, 0x400000 + 4 * (i / 2));
+}
+
+/**
+ * Check a tokenizer variant against the scalar parser on path and on each of tokenizerCases,
+ * which is written between ordinary lines so the tokenizer gets to see it, and once more as the
+ * last line of a file without its '\n'
+*/
+static bool verifyTokenizerKind(const string &path, const string &dir, TokenizerKind kind){
+
+    uint64_t mismatches = compareTokenizer(path, kind);
+    string casePath = dir + "/bench_tokenizer.txt";
+
+    for(int i = 0; i < (int)(sizeof(tokenizerCases) / sizeof(tokenizerCases[0])); i++){
+        for(int last = 0; last < 2; last++){
+            FILE *file = fopen(casePath.c_str(), "wb");
+            if(file == NULL)
+                return false;
+
+            writeFillerLines(file, 64);
+            fprintf(file, last ? "%s" : "%s\n", tokenizerCases[i]);
+            if(!last)
+                writeFillerLines(file, 64);
+            fclose(file);
+
+            mismatches += compareTokenizer(casePath, kind);
+        }
+    }
+    remove(casePath.c_str());
+
+    printf("Tokenizer (%s) against the scalar parser: %s\n", tokenizer_kind_name(kind), mismatches == 0 ? "OK" : "MISMATCH");
+    return mismatches == 0;
+}
+
+// Every tokenizer variant this CPU can run, not only the one the parser picks
+static bool verifyTokenizer(const string &path, const string &dir){
+
+    bool ok = true;
+    for(int kind = 0; kind < TOKENIZER_KINDS; kind++){
+        if(tokenizer_supported((TokenizerKind)kind))
+            ok &= verifyTokenizerKind(path, dir, (TokenizerKind)kind);
+    }
+    if(!tokenizer_available())
+        printf("No vectorized tokenizer is built in, nothing to verify\n");
+    printf("\n");
+    return ok;
+}
+
+/**
+ * Simulate records once without printing
+*/
+template<class Engine>
+static SimulationResults simulateOnce(const vector<TraceRecord> &records, unsigned short width){
+    RecordSource source(records.data(), records.size());
+    Engine simulator(source, width);
+    simulator.setVerbose(0);
+    simulator.simulate();
+    return simulator.getResults();
+}
+
+static void printRow(const char *phase, const char *engine, int width, long long simulatedCycles,
+    uint64_t instructions, const BenchTiming &timing){
+
+    double perSecond = timing.seconds > 0 ? instructions / timing.seconds : 0;
+    printf("%-12s%-8s", phase, engine);
+    if(width > 0)
+        printf("%-7d%-12lld", width, simulatedCycles);
+    else
+        printf("%-7s%-12s", "-", "-");
+
+    printf("%-10.4f%-14.3f", timing.seconds, perSecond / 1e6);
+    if(timing.hostCycles)
+        printf("%-14.1f", (double)timing.hostCycles / instructions);
+    else
+        printf("%-14s", "n/a");
+    printf("%.1f\n", peakRssMB());
+}
+
+/**
+ * Simulator throughput benchmark over a generated trace
+ * Usage: bench [--length N] [--widths LIST] [--mix INT,FLOAT,LOAD,STORE] [--branch-density P]
+ *              [--dep-distance D] [--deps N] [--code-size N] [--seed S] [--repeat R] [--dir DIR] [--keep]
+ *              [--verify-parser]
+*/
+int main(int argc, char *argv[]){
+
+    map<string, string> options;
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+
+        string value;
+        size_t eq = arg.find('=');
+        if(eq != string::npos){
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        }
+        else if(takesValue(arg) && i + 1 < argc)
+            value = argv[++i];
+
+        if(!takesValue(arg) && !isFlag(arg)){
+            cout<<"Unknown option "<<arg<<endl;
+            return 1;
+        }
+        options[arg] = value;
+    }
+
+    SyntheticTraceConfig config;
+    if(options.count("--length"))
+        config.length = strtoull(options["--length"].c_str(), NULL, 10);
+    if(options.count("--branch-density"))
+        config.branchDensity = atof(options["--branch-density"].c_str());
+    if(options.count("--dep-distance"))
+        config.dependencyDistance = atof(options["--dep-distance"].c_str());
+    if(options.count("--deps"))
+        config.dependenciesPerInst = atof(options["--deps"].c_str());
+    if(options.count("--code-size"))
+        config.codeSize = (uint32_t)strtoul(options["--code-size"].c_str(), NULL, 10);
+    if(options.count("--seed"))
+        config.seed = strtoull(options["--seed"].c_str(), NULL, 10);
+    if(options.count("--mix")){
+        double weights[4];
+        if(sscanf(options["--mix"].c_str(), "%lf,%lf,%lf,%lf", &weights[0], &weights[1], &weights[2], &weights[3]) != 4){
+            cout<<"Invalid value of argument --mix"<<endl;
+            return 1;
+        }
+        config.mix[0] = weights[0];
+        config.mix[1] = weights[1];
+        config.mix[3] = weights[2];
+        config.mix[4] = weights[3];
+    }
+
+    vector<unsigned short> widths;
+    if(!parseWidthList(options.count("--widths") ? options["--widths"] : "1,2,4,8", widths)){
+        cout<<"Invalid value of argument --widths"<<endl;
+        return 1;
+    }
+
+    int repeat = options.count("--repeat") ? atoi(options["--repeat"].c_str()) : 3;
+    if(repeat < 1 || config.length == 0){
+        cout<<"Invalid value of argument "<<endl;
+        return 1;
+    }
+
+    string dir = options.count("--dir") ? options["--dir"] : ".";
+    string textPath = dir + "/bench_trace.txt", binaryPath = dir + "/bench_trace.bin";
+
+    printf("Trace: %llu instructions, mix %g/%g/%g/%g, branch density %.3f, dependency distance %.1f, "
+        "%.2f dependencies/instruction, %u program counters, seed %llu\n",
+        (unsigned long long)config.length, config.mix[0], config.mix[1], config.mix[3], config.mix[4],
+        config.branchDensity, config.dependencyDistance, config.dependenciesPerInst, config.codeSize,
+        (unsigned long long)config.seed);
+    printf("Best of %d runs, MInst/s and host cycles are per simulated (or parsed) instruction, RSS is the peak so far\n\n", repeat);
+    printf("%-12s%-8s%-7s%-12s%-10s%-14s%-14s%s\n", "Phase", "Engine", "Width", "Cycles", "Seconds", "MInst/s",
+        "Host cyc/inst", "Peak RSS MB");
+
+    vector<TraceRecord> records;
+    BenchTiming timing = timeBest(1, [&](){ records = generateSyntheticTrace(config); });
+    printRow("generate", "-", 0, 0, config.length, timing);
+
+    if(!writeTextTrace(textPath, records) || !writeBinaryTrace(binaryPath, records)){
+        cerr<<"Error: cannot write the trace to "<<dir<<endl;
+        return 1;
+    }
+
+    if(options.count("--verify-parser") && !verifyTokenizer(textPath, dir)){
+        cerr<<"Error: the vectorized tokenizer and the scalar parser disagree"<<endl;
+        return 1;
+    }
+
+    bool parsed = true;
+    timing = timeBest(repeat, [&](){ parsed = parseOnce(textPath, config.length) && parsed; });
+    printRow("parse-text", tokenizer_name(), 0, 0, config.length, timing);
+    timing = timeBest(repeat, [&](){ parsed = parseOnce(binaryPath, config.length) && parsed; });
+    printRow("parse-bin", "-", 0, 0, config.length, timing);
+
+    if(!options.count("--keep")){
+        remove(textPath.c_str());
+        remove(binaryPath.c_str());
+    }
+
+    if(!parsed){
+        cerr<<"Error: the generated trace did not parse back completely"<<endl;
+        return 1;
+    }
+
+    for(int i = 0; i < (int)widths.size(); i++){
+        SimulationResults cycle, event;
+
+        timing = timeBest(repeat, [&](){ cycle = simulateOnce<Simulator>(records, widths[i]); });
+        printRow("simulate", "cycle", widths[i], cycle.cycles, config.length, timing);
+
+        timing = timeBest(repeat, [&](){ event = simulateOnce<EventSimulator>(records, widths[i]); });
+        printRow("simulate", "event", widths[i], event.cycles, config.length, timing);
+
+        if(cycle.cycles != event.cycles){
+            cerr<<"Error: engines disagree at width "<<widths[i]<<endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
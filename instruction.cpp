@@ -3,24 +3,31 @@
 
 /**
  * Default Constructor
- * Creates an empty program_counter with type "empty"
+ * Creates an empty Instruction, program_counter is EMPTY_PROGRAM_COUNTER
 */
 Instruction::Instruction() {
-    program_counter = "empty";
+    program_counter = EMPTY_PROGRAM_COUNTER;
     type = InstructionType::INTEGER;
-    dependencies = {};
+    dependencyCount = 0;
     currentStage = static_cast<InstructionStage>(0);    // default to "new" type
+    latencyLeft = 0;
 }
 
 // Parameterized constructor
-Instruction::Instruction(string pc, InstructionType t, vector<string> deps) {
+Instruction::Instruction(uint64_t pc, InstructionType t, const uint64_t *deps, int count) {
     program_counter = pc;
     type = t;
-    dependencies = deps;
+    dependencyCount = 0;
+    for (int i = 0; i < count; i++)
+        addDependency(deps[i]);
     currentStage = static_cast<InstructionStage>(0);    // default to "new" type
+    latencyLeft = 0;
 }
 
 // Method to add a dependency
-void Instruction::addDependency(string dep) {
-    dependencies.push_back(dep);
+bool Instruction::addDependency(uint64_t dep) {
+    if (dependencyCount == TRACE_MAX_DEPENDENCIES)
+        return false;
+    dependencies[dependencyCount++] = dep;
+    return true;
 }
@@ -1,12 +1,16 @@
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "TraceParser.h"
 
 using namespace std;
 
 #ifndef INSTRUCTION_H_
 #define INSTRUCTION_H_
 
-enum class InstructionType {
+enum class InstructionType : uint8_t {
 INTEGER,
 FLOATING_POINT,
 BRANCH,
@@ -15,7 +19,7 @@ STORE
 };
 
 // Shlok Koirala: added to track instruction stage (interchangably used with "phase" in comments)
-enum class InstructionStage {
+enum class InstructionStage : uint8_t {
 NW, // New
 IF, // Fetch
 DE, // Decode
@@ -25,23 +29,42 @@ WB, // Write Back
 RT  // Retired
 };
 
+// program_counter of an empty Instruction
+const uint64_t EMPTY_PROGRAM_COUNTER = UINT64_MAX;
+
+// Sequence number of an instruction that is not in the pipeline
+const uint64_t NO_PRODUCER = UINT64_MAX;
+
+/**
+ * One instruction of the trace and its pipeline state
+ * Fixed size and trivially copyable: dependencies are stored inline (the trace format allows at most
+ * TRACE_MAX_DEPENDENCIES), so copying or moving an instruction through the window never allocates.
+ * Bookkeeping that only the simulators need (sequence numbers, resolved producers) is kept by them.
+*/
 class Instruction {
 public:
 
     Instruction();
     
-    // Parameterized constructor
-    Instruction(string pc, InstructionType type, vector<string> deps);
+    // Parameterized constructor, dependencies beyond TRACE_MAX_DEPENDENCIES are dropped
+    Instruction(uint64_t pc, InstructionType type, const uint64_t *deps, int dependencyCount);
     
     // Member variables
-    string program_counter;
+    uint64_t program_counter;
+    uint64_t dependencies[TRACE_MAX_DEPENDENCIES];  // first dependencyCount are used
     InstructionType type;
     InstructionStage currentStage;
-    vector<string> dependencies;
+    uint8_t dependencyCount;
 
-    // Method to add a dependency
-    void addDependency(string dep);
+    // Cycles left in the functional unit the instruction occupies, set by the Simulator
+    int latencyLeft;
+
+    // Method to add a dependency, returns false if all TRACE_MAX_DEPENDENCIES slots are taken
+    bool addDependency(uint64_t dep);
 
 };
 
+static_assert(is_trivially_copyable<Instruction>::value, "Instruction must stay trivially copyable");
+static_assert(sizeof(Instruction) <= 48, "Instruction must stay within 48 bytes");
+
 #endif
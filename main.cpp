@@ -1,21 +1,219 @@
 #include <iostream>
+#include <cstdio>
+#include <map>
+#include <csignal>
 
 #include "ReadInput.h"
 #include "Simulator.h"
+#include "EventSimulator.h"
+#include "Sweep.h"
+#include "Sampling.h"
+#include "PrefetchSource.h"
+#include "Batch.h"
+#include "Dataflow.h"
+#include "OutOfOrderSimulator.h"
 
 using namespace std;
 
+// Options that take a value, everything else starting with "--" is a flag
+static const char *valueOptions[] = {"--widths", "--sample-length", "--sample-period", "--sample-points",
+    "--warmup", "--threads", "--engine", "--stats-json", "--stats-csv",
+    "--timeline", "--timeline-start", "--timeline-end", "--checkpoint", "--checkpoint-every", "--restore",
+    "--units", "--batch", "--batch-csv", "--report-interval", "--telemetry", "--telemetry-interval",
+    "--rob", "--iq", "--profile", "--profile-top"};
+
+static bool takesValue(const string &option){
+    for(int i = 0; i < (int)(sizeof(valueOptions) / sizeof(valueOptions[0])); i++)
+        if(option == valueOptions[i])
+            return true;
+    return false;
+}
+
+static const char *flagOptions[] = {"--parse-only", "--prefetch", "--dataflow"};
+
+static bool isFlag(const string &option){
+    for(int i = 0; i < (int)(sizeof(flagOptions) / sizeof(flagOptions[0])); i++)
+        if(option == flagOptions[i])
+            return true;
+    return false;
+}
+
+// SIGUSR1 saves a checkpoint at the end of the current cycle
+static void onCheckpointSignal(int){
+    requestCheckpoint();
+}
+
 int main(int argc, char *argv[]){
 
-    if(argc != 5){
+    // Options start with "--" and may appear anywhere, everything else is positional
+    // Options taking a value accept both "--option value" and "--option=value"
+    vector<string> args;
+    map<string, string> options;
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0){
+            args.push_back(arg);
+            continue;
+        }
+
+        string value;
+        size_t eq = arg.find('=');
+        if(eq != string::npos){
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        }
+        else if(takesValue(arg) && i + 1 < argc)
+            value = argv[++i];
+
+        if(!takesValue(arg) && !isFlag(arg)){
+            cout<<"Unknown option "<<arg<<endl;
+            return 0;
+        }
+        options[arg] = value;
+    }
+
+    // A manifest of jobs replaces every positional argument, results go to one CSV
+    if(options.count("--batch")){
+        if(!args.empty()){
+            cout<<"--batch takes no trace arguments"<<endl;
+            return 0;
+        }
+
+        vector<BatchJob> jobs;
+        string manifestError;
+        if(!loadBatchManifest(options["--batch"], jobs, manifestError)){
+            cerr<<"Error: "<<manifestError<<endl;
+            return 0;
+        }
+
+        vector<PipesimResult> results = runBatch(jobs, atoi(options["--threads"].c_str()));
+        for(int i = 0; i < (int)results.size(); i++)
+            if(!results[i].ok)
+                cerr<<"Error: job "<<i + 1<<": "<<results[i].error<<endl;
+
+        if(!writeBatchCsv(options["--batch-csv"], jobs, results))
+            cerr<<"Error: cannot write "<<options["--batch-csv"]<<endl;
+        return 0;
+    }
+
+    // The width sweep replaces the pipeline_width argument
+    bool sweep = options.count("--widths") != 0;
+    bool sampling = options.count("--sample-length") != 0 || options.count("--sample-points") != 0;
+    if(options.count("--sample-period") && (!options.count("--sample-length") || options.count("--sample-points"))){
+        cout<<"--sample-period needs --sample-length and can't be combined with --sample-points"<<endl;
+        return 0;
+    }
+
+    // So does the dataflow analysis, which doesn't simulate at all
+    bool dataflow = options.count("--dataflow") != 0;
+    if(dataflow && (sweep || sampling || options.count("--restore"))){
+        cout<<"--dataflow can't be combined with --widths, sampling or --restore"<<endl;
+        return 0;
+    }
+
+    // A restored run takes trace window and width from the checkpoint and resumes its read position
+    bool restore = options.count("--restore") != 0;
+    uint64_t restoredRead = 0;
+    if(restore){
+        unsigned short width;
+        CheckpointTrace window;
+        if(!args.empty() || sweep || sampling){
+            cout<<"--restore takes no trace arguments"<<endl;
+            return 0;
+        }
+        if(!readCheckpointHeader(options["--restore"], width, window, restoredRead)){
+            cerr<<"Error: cannot read checkpoint "<<options["--restore"]<<endl;
+            return 0;
+        }
+        args.push_back(window.path);
+        args.push_back(to_string(window.startInst));
+        args.push_back(to_string(window.instCount));
+        args.push_back(to_string(width));
+    }
+
+    if(args.size() != (sweep || dataflow ? 3u : 4u)){
         cout<<"Insufficient arguments "<<endl;
         return 0;
     }
 
-    string trace_file_name = argv[1];
-    int start_inst = atoi(argv[2]);
-    int inst_count = atoi(argv[3]);
-    int w = atoi(argv[4]);
+    string trace_file_name = args[0];
+    long long start_inst = atoll(args[1].c_str());
+    long long inst_count = atoll(args[2].c_str());
+    int w = sweep || dataflow ? 1 : atoi(args[3].c_str());
+
+    // "cycle" (default) advances the clock one cycle at a time, "event" jumps between stage transitions,
+    // "ooo" is the out-of-order core
+    string engine = options.count("--engine") ? options["--engine"] : "cycle";
+    if(engine != "cycle" && engine != "event" && engine != "ooo"){
+        cout<<"Invalid value of argument "<<endl;
+        return 0;
+    }
+    bool eventEngine = engine == "event";
+    bool oooEngine = engine == "ooo";
+
+    // The out-of-order core only reports its totals, from a single run
+    if(oooEngine && (sweep || sampling || restore || options.count("--checkpoint"))){
+        cout<<"--engine ooo needs a single run without --widths, sampling or checkpoints"<<endl;
+        return 0;
+    }
+    if((options.count("--rob") || options.count("--iq")) && !oooEngine){
+        cout<<"--rob and --iq need --engine ooo"<<endl;
+        return 0;
+    }
+
+    // Stall attribution and histograms are only collected by the cycle engine in a single run
+    // So is the pipeline timeline
+    bool exportStats = options.count("--stats-json") != 0 || options.count("--stats-csv") != 0;
+    if(exportStats && (eventEngine || oooEngine || sweep || sampling)){
+        cout<<"--stats-json and --stats-csv need a single run of the cycle engine"<<endl;
+        return 0;
+    }
+    if(options.count("--timeline") && (eventEngine || oooEngine || sweep || sampling)){
+        cout<<"--timeline needs a single run of the cycle engine"<<endl;
+        return 0;
+    }
+    // Checkpoints don't hold the stage cycles of the instructions in flight, so they couldn't be logged
+    if(options.count("--timeline") && restore){
+        cout<<"--timeline can't be combined with --restore"<<endl;
+        return 0;
+    }
+    if(options.count("--telemetry") && (eventEngine || oooEngine || sweep || sampling)){
+        cout<<"--telemetry needs a single run of the cycle engine"<<endl;
+        return 0;
+    }
+    bool profiling = options.count("--profile") != 0 || options.count("--profile-top") != 0;
+    if(profiling && (eventEngine || oooEngine || sweep || sampling)){
+        cout<<"--profile and --profile-top need a single run of the cycle engine"<<endl;
+        return 0;
+    }
+    // The checkpoint keeps no per-PC counters, so a restored run couldn't match its own totals
+    if(profiling && restore){
+        cout<<"--profile and --profile-top can't be combined with --restore"<<endl;
+        return 0;
+    }
+    if(options.count("--units") && (eventEngine || sweep || sampling || restore)){
+        cout<<"--units needs a single run of the cycle or ooo engine (a restored run keeps the checkpoint's units)"<<endl;
+        return 0;
+    }
+
+    FunctionalUnitConfig units;
+    string unitsError;
+    if(options.count("--units") && !units.load(options["--units"], unitsError)){
+        cerr<<"Error: "<<unitsError<<endl;
+        return 0;
+    }
+
+    bool checkpoint = options.count("--checkpoint") != 0;
+    if((checkpoint || restore) && (eventEngine || sweep || sampling)){
+        cout<<"--checkpoint and --restore need a single run of the cycle engine"<<endl;
+        return 0;
+    }
+
+    vector<unsigned short> widths;
+    if(sweep && !parseWidthList(options["--widths"], widths)){
+        cout<<"Invalid value of argument "<<endl;
+        return 0;
+    }
 
     if(start_inst <= 0){
         cout<<"Invalid value of argument "<<endl;
@@ -30,10 +228,196 @@ int main(int argc, char *argv[]){
         return 0;
     }
 
-    TraceInput trace(trace_file_name, start_inst, inst_count);
+    // Progress reports every --report-interval cycles (0 for none), telemetry intervals every --telemetry-interval
+    long long reportInterval = options.count("--report-interval") ? atoll(options["--report-interval"].c_str()) :
+        SIMULATOR_REPORT_INTERVAL;
+    long long telemetryInterval = options.count("--telemetry-interval") ?
+        atoll(options["--telemetry-interval"].c_str()) : 10000;
+    // Reorder buffer and issue queue entries of the out-of-order core, 0 for its defaults
+    int robSize = atoi(options["--rob"].c_str());
+    int iqSize = atoi(options["--iq"].c_str());
+    // Program counters listed in the hot spot report
+    int profileTop = options.count("--profile-top") ? atoi(options["--profile-top"].c_str()) : 20;
+    if(reportInterval < 0 || telemetryInterval <= 0 || robSize < 0 || iqSize < 0 || profileTop < 0){
+        cout<<"Invalid value of argument "<<endl;
+        return 0;
+    }
+
+    // Simulate intervals of the window in parallel and extrapolate, the window itself is never read as a whole
+    if(sampling){
+        long long length = atoll(options["--sample-length"].c_str());
+        long long warmup = options.count("--warmup") ? atoll(options["--warmup"].c_str()) : 10000;
+        int threads = atoi(options["--threads"].c_str());
+
+        vector<SamplePoint> points;
+        bool systematic = options.count("--sample-points") == 0;
+        if(systematic){
+            long long period = options.count("--sample-period") ? atoll(options["--sample-period"].c_str()) : length;
+            if(length > 0 && period >= length)
+                points = systematicSamples(start_inst, inst_count, length, period);
+        }
+        else if(length > 0){
+            if(!parseSamplePoints(options["--sample-points"], length, points))
+                points.clear();
+
+            // Every interval must start inside the window and is cut off at its end
+            for(int i = 0; i < (int)points.size(); i++){
+                if(points[i].start < start_inst || points[i].start >= start_inst + inst_count){
+                    points.clear();
+                    break;
+                }
+                points[i].length = min(points[i].length, start_inst + inst_count - points[i].start);
+            }
+        }
+
+        if(points.empty() || warmup < 0){
+            cout<<"Invalid value of argument "<<endl;
+            return 0;
+        }
+
+        vector<SampleResult> results = runSamples(trace_file_name, points, warmup, 1, w, threads, eventEngine);
+        SamplingEstimate estimate = estimateFromSamples(results, inst_count, systematic);
+        printSamplingReport(results, estimate);
+        return 0;
+    }
+
+    // Ideal-machine bound of the window, computed chunk-parallel from the dependencies alone
+    if(dataflow){
+        DataflowLimit limit = analyzeDataflow(trace_file_name, start_inst, inst_count, units,
+            atoi(options["--threads"].c_str()));
+        if(limit.failed){
+            cerr<<"Error: cannot read instruction "<<start_inst<<" of "<<trace_file_name<<endl;
+            return 0;
+        }
+        printDataflowReport(limit);
+        return 0;
+    }
+
+    TraceInput trace(trace_file_name, start_inst + restoredRead, inst_count - restoredRead);
+
+    // Only time the trace readers, compare against the original getline reader
+    if(options.count("--parse-only")){
+        bool binary = trace.is_binary(), compressed = trace.is_compressed();
+        ParseThroughput mapped = trace.measure_parse();
+
+        // MB/s of a compressed trace counts decompressed bytes
+        printf("Parser\t\tMB/s\t\tlines/s\n");
+        printf("%s%s\t\t%.1f\t\t%.0f\n", binary ? "binary" : compressed ? "text" : "mmap", compressed ? "+inflate" : "",
+            mapped.mb_per_sec(), mapped.lines_per_sec());
+
+        // The original reader only understands uncompressed text traces
+        if(!binary && !compressed){
+            ParseThroughput legacy = TraceInput::measure_legacy_parse(trace_file_name, start_inst, inst_count);
+            printf("getline\t\t%.1f\t\t%.0f\n", legacy.mb_per_sec(), legacy.lines_per_sec());
+        }
+        return 0;
+    }
+
+    // Parse the window once and simulate every width on its own thread
+    if(sweep){
+        vector<TraceRecord> records = trace.getRecords();
+        vector<SimulationResults> results = runWidthSweep(records, widths, eventEngine);
+        printSweepTable(results);
+        return 0;
+    }
+
+    // Stream instructions straight from the trace file instead of materializing the whole window
+    // With --prefetch the file is parsed on a reader thread while the simulation runs
+    InstructionSource *source = &trace;
+    unique_ptr<PrefetchSource> prefetch;
+    if(options.count("--prefetch")){
+        prefetch.reset(new PrefetchSource(trace));
+        source = prefetch.get();
+    }
+
+    if(eventEngine){
+        EventSimulator mySimulator(*source, w);
+        mySimulator.setReportInterval(reportInterval);
+        mySimulator.simulate();
+        return 0;
+    }
+
+    if(oooEngine){
+        OutOfOrderSimulator mySimulator(*source, w, robSize, iqSize);
+        mySimulator.setUnits(units);
+        mySimulator.setReportInterval(reportInterval);
+        mySimulator.simulate();
+        return 0;
+    }
+
+    Simulator mySimulator(*source, w);
+    mySimulator.setUnits(units);
+    mySimulator.setCollectStats(exportStats);
+    mySimulator.setReportInterval(reportInterval);
+
+    // Per-interval deltas, written to --telemetry by a background thread while simulating
+    TelemetryRecorder telemetry;
+    if(options.count("--telemetry")){
+        if(!telemetry.open(options["--telemetry"], telemetryInterval)){
+            cerr<<"Error: cannot create "<<options["--telemetry"]<<endl;
+            return 0;
+        }
+        mySimulator.setTelemetry(&telemetry);
+    }
+
+    // O3PipeView log of the instructions in flight between --timeline-start and --timeline-end (cycles)
+    PipelineTimeline timeline;
+    if(options.count("--timeline")){
+        long long first = options.count("--timeline-start") ? atoll(options["--timeline-start"].c_str()) : 0;
+        long long last = options.count("--timeline-end") ? atoll(options["--timeline-end"].c_str()) : -1;
+        if(!timeline.open(options["--timeline"], first, last)){
+            cerr<<"Error: cannot create "<<options["--timeline"]<<endl;
+            return 0;
+        }
+        mySimulator.setTimeline(&timeline);
+    }
+
+    // Retirements and stall cycles per program counter, reported as the top --profile-top and written to --profile
+    HotspotProfile profile;
+    if(profiling)
+        mySimulator.setProfile(&profile);
+
+    if(restore && !mySimulator.restoreCheckpoint(options["--restore"])){
+        cerr<<"Error: cannot restore checkpoint "<<options["--restore"]<<endl;
+        return 0;
+    }
+
+    // Saved every --checkpoint-every cycles and on SIGUSR1
+    if(checkpoint){
+        CheckpointTrace window = {trace_file_name, start_inst, inst_count};
+        long long every = options.count("--checkpoint-every") ? atoll(options["--checkpoint-every"].c_str()) : 0;
+        mySimulator.setCheckpoint(options["--checkpoint"], every, window);
+#ifdef SIGUSR1
+        signal(SIGUSR1, onCheckpointSignal);
+#endif
+    }
 
-    Simulator mySimulator(trace.getTrace(), w);
     mySimulator.simulate();
 
-    return 0;
+    // An incomplete time series fails the run, the missing intervals are marked by gap rows
+    bool telemetryFailed = options.count("--telemetry") && !telemetry.close();
+    if(telemetryFailed){
+        if(telemetry.droppedSamples())
+            cerr<<"Error: "<<telemetry.droppedSamples()<<" intervals were dropped from "<<options["--telemetry"]<<endl;
+        else
+            cerr<<"Error: writing "<<options["--telemetry"]<<" failed"<<endl;
+    }
+
+    if(options.count("--timeline") && !timeline.close())
+        cerr<<"Error: writing "<<options["--timeline"]<<" failed"<<endl;
+
+    PipelineStats stats = mySimulator.getStats();
+    if(profiling){
+        cout<<endl;
+        profile.printTop(profileTop, stats.cycles);
+        if(options.count("--profile") && !profile.writeCsv(options["--profile"]))
+            cerr<<"Error: cannot write "<<options["--profile"]<<endl;
+    }
+
+    if(options.count("--stats-json") && !stats.writeJson(options["--stats-json"]))
+        cerr<<"Error: cannot write "<<options["--stats-json"]<<endl;
+    if(options.count("--stats-csv") && !stats.writeCsv(options["--stats-csv"]))
+        cerr<<"Error: cannot write "<<options["--stats-csv"]<<endl;
+
+    return telemetryFailed ? 1 : 0;
 }
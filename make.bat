@@ -1,11 +1,63 @@
+g++ -c Batch.cpp
+g++ -c BinaryTrace.cpp
+g++ -c Checkpoint.cpp
+g++ -c Dataflow.cpp
+g++ -c EventSimulator.cpp
+g++ -c FunctionalUnits.cpp
+g++ -c HotspotProfile.cpp
 g++ -c instruction.cpp
+g++ -c InstructionSource.cpp
+g++ -c InstructionWindow.cpp
+g++ -c OutOfOrderSimulator.cpp
+g++ -c PipelineStats.cpp
+g++ -c PipelineTimeline.cpp
+g++ -c pipesim.cpp
+g++ -c PrefetchSource.cpp
 g++ -c ReadInput.cpp
+g++ -c Sampling.cpp
 g++ -c Simulator.cpp
+g++ -c Sweep.cpp
+g++ -c Telemetry.cpp
+g++ -c TraceIndex.cpp
+g++ -c TraceParser.cpp
+g++ -c TraceTokenizer.cpp
 g++ -c main.cpp
 
-g++ instruction.o ReadInput.o Simulator.o main.o -o simulator
+g++ Batch.o BinaryTrace.o Checkpoint.o Dataflow.o EventSimulator.o FunctionalUnits.o HotspotProfile.o instruction.o InstructionSource.o InstructionWindow.o OutOfOrderSimulator.o PipelineStats.o PipelineTimeline.o pipesim.o PrefetchSource.o ReadInput.o Sampling.o Simulator.o Sweep.o Telemetry.o TraceIndex.o TraceParser.o TraceTokenizer.o main.o -o simulator
+ar rcs libpipesim.a Batch.o BinaryTrace.o Checkpoint.o Dataflow.o EventSimulator.o FunctionalUnits.o HotspotProfile.o instruction.o InstructionSource.o InstructionWindow.o OutOfOrderSimulator.o PipelineStats.o PipelineTimeline.o pipesim.o PrefetchSource.o ReadInput.o Sampling.o Simulator.o Sweep.o Telemetry.o TraceIndex.o TraceParser.o TraceTokenizer.o
+g++ -c tools/trace_convert.cpp -o trace_convert.o
+g++ Batch.o BinaryTrace.o Checkpoint.o Dataflow.o EventSimulator.o FunctionalUnits.o HotspotProfile.o instruction.o InstructionSource.o InstructionWindow.o OutOfOrderSimulator.o PipelineStats.o PipelineTimeline.o pipesim.o PrefetchSource.o ReadInput.o Sampling.o Simulator.o Sweep.o Telemetry.o TraceIndex.o TraceParser.o TraceTokenizer.o trace_convert.o -o tracecvt
+g++ -c bench/bench.cpp -o bench.o
+g++ -c bench/SyntheticTrace.cpp -o SyntheticTrace.o
+g++ Batch.o BinaryTrace.o Checkpoint.o Dataflow.o EventSimulator.o FunctionalUnits.o HotspotProfile.o instruction.o InstructionSource.o InstructionWindow.o OutOfOrderSimulator.o PipelineStats.o PipelineTimeline.o pipesim.o PrefetchSource.o ReadInput.o Sampling.o Simulator.o Sweep.o Telemetry.o TraceIndex.o TraceParser.o TraceTokenizer.o bench.o SyntheticTrace.o -o bench\bench
+g++ -c tests/tests.cpp -o tests.o
+g++ Batch.o BinaryTrace.o Checkpoint.o Dataflow.o EventSimulator.o FunctionalUnits.o HotspotProfile.o instruction.o InstructionSource.o InstructionWindow.o OutOfOrderSimulator.o PipelineStats.o PipelineTimeline.o pipesim.o PrefetchSource.o ReadInput.o Sampling.o Simulator.o Sweep.o Telemetry.o TraceIndex.o TraceParser.o TraceTokenizer.o tests.o -o tests\tests
+tests\tests
 
+del Batch.o
+del BinaryTrace.o
+del Checkpoint.o
+del Dataflow.o
+del EventSimulator.o
+del FunctionalUnits.o
+del HotspotProfile.o
 del instruction.o
+del InstructionSource.o
+del InstructionWindow.o
+del OutOfOrderSimulator.o
+del PipelineStats.o
+del PipelineTimeline.o
+del pipesim.o
+del PrefetchSource.o
 del ReadInput.o
+del Sampling.o
 del Simulator.o
+del Sweep.o
+del Telemetry.o
+del TraceIndex.o
+del TraceParser.o TraceTokenizer.o
 del main.o
+del trace_convert.o
+del bench.o
+del SyntheticTrace.o
+del tests.o
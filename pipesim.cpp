@@ -0,0 +1,118 @@
+#include "pipesim.h"
+#include "EventSimulator.h"
+#include "ReadInput.h"
+
+PipesimOptions::PipesimOptions(){
+    width = 1;
+    eventEngine = false;
+    warmup = 0;
+    collectStats = false;
+}
+
+PipesimResult::PipesimResult(){
+    ok = false;
+    stallsMeasured = false;
+}
+
+/**
+ * Run the engine chosen by options over source without printing anything
+*/
+PipesimResult pipesimRun(InstructionSource &source, const PipesimOptions &options){
+
+    PipesimResult result;
+    result.ok = false;
+    result.stats.reset(options.width);
+
+    if(options.width == 0){
+        result.error = "width must be at least 1";
+        return result;
+    }
+    if(!options.units.isValid()){
+        result.error = "every functional unit needs a count and latency of at least 1";
+        return result;
+    }
+
+    if(options.eventEngine){
+        if(!options.units.isDefault()){
+            result.error = "the event engine only models the default functional units";
+            return result;
+        }
+
+        EventSimulator simulator(source, options.width);
+        simulator.setVerbose(0);
+        simulator.setWarmup(options.warmup);
+        simulator.simulate();
+        result.totals = simulator.getResults();
+        result.stats.cycles = result.totals.cycles;
+        for(int i = 0; i < 5; i++)
+            result.stats.retired[i] = result.totals.retired[i];
+    }
+    else {
+        Simulator simulator(source, options.width);
+        simulator.setVerbose(0);
+        simulator.setWarmup(options.warmup);
+        simulator.setUnits(options.units);
+        simulator.setCollectStats(options.collectStats);
+        simulator.simulate();
+        result.totals = simulator.getResults();
+        result.stats = simulator.getStats();
+        result.stallsMeasured = true;
+    }
+
+    result.ok = true;
+    return result;
+}
+
+PipesimResult pipesimRunRecords(const TraceRecord *records, size_t count, const PipesimOptions &options){
+    RecordSource source(records, count);
+    return pipesimRun(source, options);
+}
+
+PipesimResult pipesimRunCallback(std::function<bool(TraceRecord&)> produce, const PipesimOptions &options){
+    CallbackSource source(produce);
+    return pipesimRun(source, options);
+}
+
+/**
+ * Stream the window straight from the file
+ * The trace is checked up front, an unreadable or short trace is reported instead of ending the process
+*/
+PipesimResult pipesimRunFile(const std::string &path, long long startInst, long long instCount,
+    const PipesimOptions &options){
+
+    PipesimResult result;
+    result.ok = false;
+    result.stats.reset(options.width);
+
+    if(startInst <= 0 || instCount <= 0){
+        result.error = "the trace window must start at instruction 1 or later and hold at least one instruction";
+        return result;
+    }
+
+    TraceInput trace(path, startInst, instCount);
+    if(trace.file_failed){
+        result.error = "cannot open " + path + " or it has fewer than " + std::to_string(startInst) + " instructions";
+        return result;
+    }
+
+    // Read through CallbackSource so the end of the file or a malformed line ends the simulation
+    // instead of exiting like TraceInput::get_next_instruction()
+    long long remaining = instCount;
+    bool truncated = false;
+    PipesimResult run = pipesimRunCallback([&](TraceRecord &record){
+        if(remaining == 0)
+            return false;
+        if(!trace.try_next_record(record)){
+            truncated = true;
+            return false;
+        }
+        remaining--;
+        return true;
+    }, options);
+
+    if(truncated && run.ok){
+        run.ok = false;
+        run.error = path + " ends or has a malformed line before instruction " + std::to_string(startInst + instCount - 1);
+    }
+    return run;
+}
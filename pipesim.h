@@ -0,0 +1,56 @@
+#include <string>
+#include <functional>
+
+#include "TraceParser.h"
+#include "InstructionSource.h"
+#include "FunctionalUnits.h"
+#include "PipelineStats.h"
+#include "Simulator.h"
+
+#ifndef PIPESIM_H_
+#define PIPESIM_H_
+
+/**
+ * Library interface of the simulator (libpipesim.a)
+ * Every call runs one complete, silent simulation and returns its numbers; nothing is printed and no
+ * state is shared between calls, so they can be made any number of times and from several threads.
+*/
+
+// How to simulate
+struct PipesimOptions {
+    unsigned short width;
+    bool eventEngine;               // EventSimulator, default units only and no stall statistics
+    FunctionalUnitConfig units;
+    long long warmup;               // instructions excluded from measuredCycles/measuredRetired
+    bool collectStats;              // fill the occupancy and retirement histograms of PipesimResult::stats
+
+    // Constructor: width 1, cycle engine, default units, no warmup, stall counters only
+    PipesimOptions();
+};
+
+// Outcome of one simulation
+struct PipesimResult {
+    bool ok;                        // false if the source could not be read or the options are invalid
+    std::string error;
+    SimulationResults totals;       // cycles, retired instructions per type, IPC
+    PipelineStats stats;            // stall cycles by cause and histograms (cycle engine only)
+    bool stallsMeasured;            // whether stats.stalls was counted; false for the event engine, whose zeros mean nothing
+
+    // Constructor: not ok, nothing measured
+    PipesimResult();
+};
+
+// Simulates everything source produces
+PipesimResult pipesimRun(InstructionSource &source, const PipesimOptions &options);
+
+// Simulates count decoded records, which are only read
+PipesimResult pipesimRunRecords(const TraceRecord *records, size_t count, const PipesimOptions &options);
+
+// Simulates the records a callback produces until it returns false
+PipesimResult pipesimRunCallback(std::function<bool(TraceRecord&)> produce, const PipesimOptions &options);
+
+// Simulates instCount instructions of a trace file (text, binary or compressed) starting at startInst (1-based)
+PipesimResult pipesimRunFile(const std::string &path, long long startInst, long long instCount,
+    const PipesimOptions &options);
+
+#endif
@@ -0,0 +1,212 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#include "../InstructionSource.h"
+#include "../Simulator.h"
+#include "../HotspotProfile.h"
+#include "../TraceParser.h"
+#include "../TraceTokenizer.h"
+
+using namespace std;
+
+/**
+ * Regression tests, run by "make test"
+ * A failed CHECK prints its condition and line, main exits non-zero if any of them failed.
+*/
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)){ \
+            cerr<<__FILE__<<":"<<__LINE__<<": check failed: "<<#condition<<endl; \
+            failures++; \
+        } \
+    } while(0)
+
+// Record of the given pc and type, depending on the instruction at producer unless it is 0
+static TraceRecord makeRecord(uint64_t pc, int type, uint64_t producer){
+    TraceRecord record = TraceRecord();
+    record.program_counter = pc;
+    record.type = type;
+    if(producer != 0){
+        record.dependencies[0] = producer;
+        record.dependency_count = 1;
+    }
+    return record;
+}
+
+/**
+ * Profile a trace whose program counters include 0xffffffffffffffff, first on an empty table and
+ * again once the table has grown, and check every retirement and stall lands on the right PC
+*/
+static void testProfileAllOnesPc(){
+
+    const uint64_t allOnes = UINT64_MAX;
+    vector<TraceRecord> records;
+    long long allOnesCount = 0;
+
+    for(int round = 0; round < 2; round++){
+        // The all-ones PC is the very first one the profile sees, then a load it depends on
+        records.push_back(makeRecord(allOnes, 3, 0));
+        records.push_back(makeRecord(0, 0, allOnes));
+        records.push_back(makeRecord(allOnes, 0, 0));
+        allOnesCount += 2;
+
+        // Enough distinct PCs to grow the table a few times
+        for(uint64_t pc = 0x400000; pc < 0x400000 + 4 * 20000; pc += 4)
+            records.push_back(makeRecord(pc, (pc / 4) % 5, pc - 4));
+    }
+
+    RecordSource source(records.data(), records.size());
+    Simulator simulator(source, 2);
+    simulator.setVerbose(0);
+    simulator.setReportInterval(0);
+    HotspotProfile profile;
+    simulator.setProfile(&profile);
+    simulator.simulate();
+    PipelineStats stats = simulator.getStats();
+
+    CHECK(profile.size() == 20000 + 2);
+
+    vector<HotspotEntry> entries = profile.ranked();
+    long long retired = 0, stalls = 0, allOnesRetired = -1, zeroRetired = -1;
+    for(size_t i = 0; i < entries.size(); i++){
+        retired += entries[i].retired;
+        stalls += entries[i].totalStalls();
+        if(entries[i].program_counter == allOnes)
+            allOnesRetired = entries[i].retired;
+        if(entries[i].program_counter == 0)
+            zeroRetired = entries[i].retired;
+    }
+
+    CHECK(retired == (long long)records.size());
+    CHECK(stalls == stats.totalStalls());
+    CHECK(allOnesRetired == allOnesCount);
+    CHECK(zeroRetired == 2);
+}
+
+// Lines the tokenizer must leave to the scalar parser or decode exactly like it
+static const char *tokenizerCases[] = {
+    "400000,1,ABCDEF,0Xabc,0x12", "0x0123456789abcdef,2", "123456789abcdef0,3", "fffffffffffffffff,1",
+    "0x1,4,0x2,", "0x1,5,", "10,1,20\r", "10,1,20\r\r", ",1", "0x,1", "10,6", "10,0", "10,12", "10,1,,20",
+    "10,1,2,3,4,5", "10,1,2,3,4,5,6", "10 ,1", "10,1,0x", "10,1,0xg", "x10,1", "10,1,20,30,40,50\r",
+    "0xffffffffffffffff,1,0xffffffffffffffff,0x0000000000000000001",
+    "0x1234567890abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef,1",
+    "10,1,20"
+};
+
+/**
+ * Write count well-formed lines covering every field length from 1 to 15 digits, with and without
+ * "0x", in both cases, with 0 - 4 dependencies and LF or CRLF endings
+*/
+static void writeTokenizerLines(FILE *file, int count, uint64_t seed){
+    for(int i = 0; i < count; i++){
+        int deps = i % 5;
+        for(int field = 0; field <= deps + 1; field++){
+            if(field == 1){
+                fprintf(file, ",%d", (int)(seed >> 33) % 5 + 1);
+                continue;
+            }
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            int digits = (int)(seed >> 60) % 15 + 1;
+            uint64_t value = (seed >> 4) & (~0ULL >> (64 - 4 * digits));
+            const char *prefix = (seed & 3) == 0 ? "0x" : (seed & 3) == 1 ? "0X" : "";
+            fprintf(file, (seed & 4) ? "%s%s%0*llX" : "%s%s%0*llx", field ? "," : "", prefix, digits,
+                (unsigned long long)value);
+        }
+        fprintf(file, i % 7 == 0 ? "\r\n" : "\n");
+    }
+}
+
+/**
+ * Read path with tokenizer variant kind and with the scalar parser side by side
+ * @return whether every record, error and read position agrees
+*/
+static bool sameAsScalar(const string &path, TokenizerKind kind){
+
+    TraceParser vectorized, scalar;
+    vectorized.set_tokenizer_kind(kind);
+    scalar.set_tokenizer(false);
+    if(!vectorized.open(path) || !scalar.open(path))
+        return false;
+
+    bool same = true;
+    while(same){
+        TraceRecord a, b;
+        bool gotA = vectorized.next(a), gotB = scalar.next(b);
+
+        same = gotA == gotB && vectorized.malformed == scalar.malformed &&
+            vectorized.lines_read() == scalar.lines_read() && vectorized.bytes_read() == scalar.bytes_read();
+        if(same && gotA){
+            same = a.program_counter == b.program_counter && a.type == b.type && a.dependency_count == b.dependency_count;
+            for(int i = 0; same && i < a.dependency_count; i++)
+                same = a.dependencies[i] == b.dependencies[i];
+        }
+        if(!same)
+            cerr<<"Tokenizer ("<<tokenizer_kind_name(kind)<<") differs at line "<<scalar.lines_read()<<" of "<<path<<endl;
+        if(!gotA || !gotB)
+            break;
+    }
+
+    vectorized.close();
+    scalar.close();
+    return same;
+}
+
+/**
+ * Every tokenizer variant the CPU can run decodes generated lines and each of tokenizerCases (between
+ * ordinary lines, and once as the last line without its '\n') exactly like the scalar parser
+*/
+static void testTokenizerVariants(){
+
+    const string path = "tests_tokenizer.txt";
+    int cases = sizeof(tokenizerCases) / sizeof(tokenizerCases[0]);
+
+    for(int kind = 0; kind < TOKENIZER_KINDS; kind++){
+        if(!tokenizer_supported((TokenizerKind)kind))
+            continue;
+
+        FILE *file = fopen(path.c_str(), "wb");
+        CHECK(file != NULL);
+        if(file == NULL)
+            return;
+        writeTokenizerLines(file, 20000, kind + 1);
+        fclose(file);
+        CHECK(sameAsScalar(path, (TokenizerKind)kind));
+
+        for(int i = 0; i < cases; i++){
+            for(int last = 0; last < 2; last++){
+                file = fopen(path.c_str(), "wb");
+                if(file == NULL)
+                    return;
+                writeTokenizerLines(file, 64, i);
+                fprintf(file, last ? "%s" : "%s\n", tokenizerCases[i]);
+                if(!last)
+                    writeTokenizerLines(file, 64, i + cases);
+                fclose(file);
+                CHECK(sameAsScalar(path, (TokenizerKind)kind));
+            }
+        }
+    }
+    remove(path.c_str());
+
+    // The variant the parser picks by default is one of those checked
+    CHECK(!tokenizer_available() || tokenizer_supported(tokenizer_kind()));
+}
+
+int main(){
+
+    testProfileAllOnesPc();
+    testTokenizerVariants();
+
+    if(failures){
+        cerr<<failures<<" checks failed"<<endl;
+        return 1;
+    }
+    cout<<"All tests passed"<<endl;
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <cstdio>
+#include <chrono>
+
+#include "../TraceParser.h"
+#include "../BinaryTrace.h"
+
+using namespace std;
+
+/**
+ * Converts a text trace into the binary trace format (or back with --to-text)
+ * Usage: tracecvt input_trace output_file [--to-text]
+*/
+int main(int argc, char *argv[]){
+
+    if(argc != 3 && !(argc == 4 && string(argv[3]) == "--to-text")){
+        cout<<"Usage: tracecvt input_trace output_file [--to-text]"<<endl;
+        return 1;
+    }
+
+    bool toText = argc == 4;
+
+    TraceParser parser;
+    if(!parser.open(argv[1])){
+        cerr<<"Error: cannot open "<<argv[1]<<endl;
+        return 1;
+    }
+
+    BinaryTraceWriter writer;
+    FILE *text = NULL;
+    bool opened = toText ? (text = fopen(argv[2], "w")) != NULL : writer.open(argv[2]);
+    if(!opened){
+        cerr<<"Error: cannot create "<<argv[2]<<endl;
+        return 1;
+    }
+
+    auto begin = chrono::steady_clock::now();
+
+    TraceRecord record;
+    uint64_t count = 0;
+    bool ok = true;
+    while(ok && parser.next(record)){
+        if(toText){
+            ok = fprintf(text, "%llx,%d", (unsigned long long)record.program_counter, record.type + 1) > 0;
+            for(int i = 0; i < record.dependency_count; i++)
+                ok = ok && fprintf(text, ",%llx", (unsigned long long)record.dependencies[i]) > 0;
+            ok = ok && fputc('\n', text) != EOF;
+        }
+        else
+            ok = writer.write(record);
+        count++;
+    }
+
+    if(parser.malformed){
+        cerr<<"Error: invalid line format at instruction "<<count + 1<<endl;
+        return 1;
+    }
+
+    ok = (toText ? fclose(text) == 0 : writer.close()) && ok;
+    if(!ok){
+        cerr<<"Error: writing "<<argv[2]<<" failed"<<endl;
+        return 1;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    printf("Converted %llu instructions (%.1f MB read) in %.2f s\n",
+        (unsigned long long)count, parser.bytes_read() / 1e6, seconds);
+
+    return 0;
+}